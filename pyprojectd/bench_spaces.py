@@ -0,0 +1,76 @@
+import os
+import sys
+import site
+import time
+
+# Compares ODE collision space types ([COLLISION_SPACE] in cfg/sim.ini) by wall time per step.
+# usage: python bench_spaces.py [num_cars] [num_steps]
+
+sim_rate = 1.0 / 333.0
+num_cars = int(sys.argv[1]) if len(sys.argv) > 1 else 24
+num_steps = int(sys.argv[2]) if len(sys.argv) > 2 else 2000
+warmup_steps = 200
+
+track_names = ['ks_nordschleife', 'driftplayground']
+car_model = 'ks_toyota_ae86_drift'
+
+# (static, dynamic)
+space_configs = [
+    ('SIMPLE', 'SIMPLE'),
+    ('HASH', 'HASH'),
+    ('QUADTREE', 'HASH'),
+    ('QUADTREE', 'SAP'),
+    ('HASH', 'SAP'),
+]
+
+base_dir = os.path.join(os.path.dirname(os.path.realpath(__file__)), '..')
+bin_dir = os.path.join(base_dir, 'bin')
+site.addsitedir(bin_dir)
+if hasattr(os, 'add_dll_directory'):
+    os.add_dll_directory(bin_dir)
+
+import PyProjectD as pd
+pd.setLogFile(os.path.join(base_dir, 'projectd_bench.log'), True)
+
+def run(track_name, static_space, dynamic_space):
+    sim = pd.createSimulator(base_dir)
+    pd.setSimulatorDeterministic(sim, True, False)
+    pd.setSimulatorCollisionSpaces(sim, static_space, dynamic_space)
+    pd.loadTrack(sim, track_name)
+
+    controls = pd.CarControls()
+    controls.gas = 0.4
+
+    # pairs of cars close together so car vs car broadphase has work to do
+    for i in range(num_cars):
+        car = pd.addCar(sim, car_model)
+        pd.teleportCarToSpline(sim, car, 0.01 + (i // 2) * (0.9 / max(1, num_cars // 2)) + (i % 2) * 0.0005)
+        pd.setCarAssists(sim, car, True, True, True)
+        pd.setCarControls(sim, car, False, controls)
+
+    for _ in range(warmup_steps):
+        pd.stepSimulator(sim, sim_rate)
+
+    t0 = time.perf_counter()
+    for _ in range(num_steps):
+        pd.stepSimulator(sim, sim_rate)
+    t1 = time.perf_counter()
+
+    pd.destroySimulator(sim)
+    return (t1 - t0) * 1000.0 / num_steps
+
+print('cars=%d steps=%d' % (num_cars, num_steps))
+
+for track_name in track_names:
+    if not os.path.exists(os.path.join(base_dir, 'content', 'tracks', track_name, 'surfaces.bin')):
+        print('%s: surfaces.bin not found, skipped' % track_name)
+        continue
+
+    baseline = None
+    for static_space, dynamic_space in space_configs:
+        ms = run(track_name, static_space, dynamic_space)
+        if baseline is None:
+            baseline = ms
+        print('%-20s static=%-8s dynamic=%-8s %8.3f ms/step %6.2fx' % (track_name, static_space, dynamic_space, ms, baseline / ms))
+
+pd.shutAll()
@@ -0,0 +1,45 @@
+import os
+import sys
+import site
+import time
+
+# Cooks content/tracks/<track>/track.trackpack from surfaces.bin, spline.bin and ini files.
+# Package is picked up by loadTrack when [TRACK_PACK] ENABLED=1, cook again after editing track sources.
+# usage: python cook_tracks.py [track_name ...], all tracks with surfaces.bin when omitted
+
+base_dir = os.path.join(os.path.dirname(os.path.realpath(__file__)), '..')
+bin_dir = os.path.join(base_dir, 'bin')
+site.addsitedir(bin_dir)
+if hasattr(os, 'add_dll_directory'):
+    os.add_dll_directory(bin_dir)
+
+import PyProjectD as pd
+pd.setLogFile(os.path.join(base_dir, 'projectd_cook.log'), True)
+
+tracks_dir = os.path.join(base_dir, 'content', 'tracks')
+
+track_names = sys.argv[1:]
+if not track_names:
+    track_names = sorted(name for name in os.listdir(tracks_dir) if os.path.exists(os.path.join(tracks_dir, name, 'surfaces.bin')))
+
+sim = pd.createSimulator(base_dir)
+
+for track_name in track_names:
+    t0 = time.perf_counter()
+    ok = pd.cookTrack(sim, track_name)
+    t1 = time.perf_counter()
+
+    if not ok:
+        print('%-30s FAILED' % track_name)
+        continue
+
+    # load time of the cooked package
+    pd.loadTrack(sim, track_name)
+    t2 = time.perf_counter()
+    pd.unloadTrack(sim)
+
+    size = os.path.getsize(os.path.join(tracks_dir, track_name, 'track.trackpack'))
+    print('%-30s cook %8.1f ms  load %8.1f ms  %8.1f MB' % (track_name, (t1 - t0) * 1000.0, (t2 - t1) * 1000.0, size / (1024.0 * 1024.0)))
+
+pd.destroySimulator(sim)
+pd.shutAll()
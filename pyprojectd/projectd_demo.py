@@ -48,7 +48,8 @@ car_tunes = {
 base_dir = os.path.join(os.path.dirname(os.path.realpath(__file__)), '..')
 bin_dir = os.path.join(base_dir, 'bin')
 site.addsitedir(bin_dir)
-os.add_dll_directory(bin_dir)
+if hasattr(os, 'add_dll_directory'):
+    os.add_dll_directory(bin_dir)
 
 import PyProjectD as pd
 pd.setLogFile(os.path.join(base_dir, 'projectd.log'), True);
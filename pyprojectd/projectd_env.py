@@ -9,7 +9,8 @@ import numpy as np
 base_dir = os.path.join(os.path.dirname(os.path.realpath(__file__)), '..')
 bin_dir = os.path.join(base_dir, 'bin')
 site.addsitedir(bin_dir)
-os.add_dll_directory(bin_dir)
+if hasattr(os, 'add_dll_directory'):
+    os.add_dll_directory(bin_dir)
 
 import PyProjectD as pd
 import utils_d as u
@@ -17,6 +18,7 @@ import utils_d as u
 class ProjectDEnv():
 
     sim_dt = 1.0 / 333.0
+    action_repeat = 1 # physics substeps per action
     render_hz = 60
     viewer_enabled = False
 
@@ -131,12 +133,15 @@ class ProjectDEnv():
         for name, value in self.scoring_vars.items():
             pd.setScoringVar(self.sim, self.car, name, value)
         
-        self.dstate = pd.CarState()
         self.dcontrols = pd.CarControls()
+        self.state_buffer = pd.createCarStateBuffer([self.sim])
+        self.state_view = self.state_buffer.array()[0] # zero-copy, updated by simulator
         self.sim_initialized = True
 
     def del_sim(self):
         if self.sim_initialized:
+            self.state_view = None
+            self.state_buffer.release()
             pd.destroySimulator(self.sim)
             self.sim_initialized = False
 
@@ -167,46 +172,45 @@ class ProjectDEnv():
         if not self.auto_shift:
             self.dcontrols.requestedGearIndex = 2 # 0=R, 1=N, 2=G1, 3=G2, 4=G3, 5=G4, 6=G5, 7=G6
         
-        pd.setCarControls(self.sim, self.car, self.smooth_controls, self.dcontrols)
-        pd.stepSimulator(self.sim, self.sim_dt)
+        reward, _ = pd.stepCar(self.sim, self.car, self.smooth_controls, self.dcontrols, self.state_buffer, 
+            self.action_repeat, self.sim_dt, self.terminate_on_hit, self.terminate_off_track)
         
         if self.viewer_initialized:
             pd.tickPlayground()
         elif self.viewer_enabled and self.step_id > 5:
             self.init_viewer()
 
-        pd.getCarState(self.sim, self.car, self.dstate)
         self.step_id += 1
 
+        s = self.state_view
         state = self._get_obs_state()
-        reward = self.dstate.stepReward
         terminate = False
         truncate = False
 
-        if self.terminate_on_hit and self.dstate.collisionFlag != 0:
+        if self.terminate_on_hit and s['collisionFlag'] != 0:
             pd.writeLog('[ENV] collision')
             reward -= self.terminate_hit_penalty
             terminate = True
 
-        if self.terminate_off_track and self.dstate.outOfTrackFlag != 0:
+        if self.terminate_off_track and s['outOfTrackFlag'] != 0:
             pd.writeLog('[ENV] offtrack')
             reward -= self.terminate_off_track_penalty
             terminate = True
 
-        if self.terminate_when_stuck and self.dstate.lastTrackPointTimestamp + self.stuck_timeout < self.dstate.timestamp:
+        if self.terminate_when_stuck and s['lastTrackPointTimestamp'] + self.stuck_timeout < s['timestamp']:
             pd.writeLog('[ENV] stuck')
             reward -= self.terminate_stuck_penalty
             terminate = True
 
         self.total_reward += reward
 
-        #if self.dstate.totalReward < self.terminate_low_reward:
+        #if s['totalReward'] < self.terminate_low_reward:
         if self.total_reward < self.terminate_low_reward:
             pd.writeLog('[ENV] low reward')
             terminate = True
 
         if terminate:
-            #pd.writeLog('[ENV] total reward: ' + str(self.dstate.totalReward))
+            #pd.writeLog('[ENV] total reward: ' + str(s['totalReward']))
             pd.writeLog('[ENV] total reward: ' + str(self.total_reward))
 
         return state, reward, terminate, truncate, {}
@@ -235,48 +239,31 @@ class ProjectDEnv():
     #==============================================================================================
     
     def _get_obs_state(self):
-        
-        state = np.array([
 
-            #u.linscalef(self.dstate.engineRPM, 0.0, 20000.0, 0.0, 1.0),
-            
-            self.dstate.localVelocity.x, # m/s
-            self.dstate.localVelocity.y,
-            self.dstate.localVelocity.z,
+        # single simulator env: first 5 lookAhead and 7 probes, track profile features are vec env only
 
-            self.dstate.localAngularVelocity.x, # rad/s
-            self.dstate.localAngularVelocity.y,
-            self.dstate.localAngularVelocity.z,
-            
-            self.dstate.tyreNdSlip[0],
-            self.dstate.tyreNdSlip[1],
-            self.dstate.tyreNdSlip[2],
-            self.dstate.tyreNdSlip[3],
-            
-            self.dstate.bodyVsTrack, # body_direction dot track_direction
-            self.dstate.velocityVsTrack, # velocity dot track_direction
-
-            self.dstate.lookAhead[0], # track direction change [-PI, PI]
-            self.dstate.lookAhead[1],
-            self.dstate.lookAhead[2],
-            self.dstate.lookAhead[3],
-            self.dstate.lookAhead[4],
-
-            self.dstate.probes[0], # distance to obstacle, m
-            self.dstate.probes[1],
-            self.dstate.probes[2],
-            self.dstate.probes[3],
-            self.dstate.probes[4],
-            self.dstate.probes[5],
-            self.dstate.probes[6],
-            
-        ], dtype=np.float32)
+        s = self.state_view
+        state = np.concatenate((
+
+            #[u.linscalef(s['engineRPM'], 0.0, 20000.0, 0.0, 1.0)],
+
+            s['localVelocity'], # m/s
+            s['localAngularVelocity'], # rad/s
+            s['tyreNdSlip'],
+            [s['bodyVsTrack'], # body_direction dot track_direction
+             s['velocityVsTrack']], # velocity dot track_direction
+            s['lookAhead'][:5], # track direction change [-PI, PI]
+            s['probes'][:7], # distance to obstacle, m
+
+        ), dtype=np.float32)
         
         return state
 
     #==============================================================================================
 
-    def _get_obs_space(self):
+    def _get_obs_space(self, num_look_ahead=5, num_probes=7, num_profile=0):
+
+        # num_profile: [CAR_LOOK_AHEAD] PROFILE_COUNT samples of 6 features, only appended by SimulatorPool (ProjectDVecEnv)
        
         obs_low = np.array([
 
@@ -298,19 +285,9 @@ class ProjectDEnv():
             -1.0, # bodyVsTrack
             -1.0, # velocityVsTrack
             
-            -self.range_lookAhead, # lookAhead0
-            -self.range_lookAhead, # lookAhead1
-            -self.range_lookAhead, # lookAhead2
-            -self.range_lookAhead, # lookAhead3
-            -self.range_lookAhead, # lookAhead4
-
-            0.0, # probe0
-            0.0, # probe1
-            0.0, # probe2
-            0.0, # probe3
-            0.0, # probe4
-            0.0, # probe5
-            0.0, # probe6
+            *([-self.range_lookAhead] * num_look_ahead), # lookAhead
+            *([0.0] * num_probes), # probe
+            *([-np.inf] * (num_profile * 6)), # curvature, heading, width, elevation, banking, grip
 
         ], dtype=np.float32)
         
@@ -334,19 +311,9 @@ class ProjectDEnv():
             1.0, # bodyVsTrack
             1.0, # velocityVsTrack
 
-            self.range_lookAhead, # lookAhead0
-            self.range_lookAhead, # lookAhead1
-            self.range_lookAhead, # lookAhead2
-            self.range_lookAhead, # lookAhead3
-            self.range_lookAhead, # lookAhead4
-            
-            self.range_probe, # probe0
-            self.range_probe, # probe1
-            self.range_probe, # probe2
-            self.range_probe, # probe3
-            self.range_probe, # probe4
-            self.range_probe, # probe5
-            self.range_probe, # probe6
+            *([self.range_lookAhead] * num_look_ahead), # lookAhead
+            *([self.range_probe] * num_probes), # probe
+            *([np.inf] * (num_profile * 6)), # curvature, heading, width, elevation, banking, grip
             
         ], dtype=np.float32)
         
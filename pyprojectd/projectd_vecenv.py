@@ -0,0 +1,105 @@
+import numpy as np
+from gymnasium import spaces as gym_spaces
+from stable_baselines3.common.vec_env.base_vec_env import VecEnv
+
+from projectd_env import ProjectDEnv, pd, base_dir
+
+class ProjectDVecEnv(VecEnv):
+
+    # native pool of simulators stepped in parallel, env settings are taken from ProjectDEnv
+
+    def __init__(self, num_envs, num_threads=0, action_repeat=1, **kwargs):
+
+        cfg = ProjectDEnv
+        self.cfg = cfg
+
+        pcfg = pd.SimulatorPoolConfig()
+        pcfg.basePath = base_dir
+        pcfg.trackName = cfg.track_name
+        pcfg.carModel = cfg.car_model
+        pcfg.numSimulators = num_envs
+        pcfg.numThreads = num_threads
+        pcfg.substeps = action_repeat
+        pcfg.dt = cfg.sim_dt
+        pcfg.smoothSteer = cfg.smooth_controls
+        pcfg.autoClutch = cfg.auto_clutch
+        pcfg.autoShift = cfg.auto_shift
+        pcfg.autoBlip = cfg.auto_blip
+        pcfg.teleportMode = cfg.teleport_mode
+        pcfg.autoReset = True
+        pcfg.terminateOnHit = cfg.terminate_on_hit
+        pcfg.terminateOffTrack = cfg.terminate_off_track
+        pcfg.terminateWhenStuck = cfg.terminate_when_stuck
+        pcfg.terminateHitPenalty = cfg.terminate_hit_penalty
+        pcfg.terminateOffTrackPenalty = cfg.terminate_off_track_penalty
+        pcfg.terminateStuckPenalty = cfg.terminate_stuck_penalty
+        pcfg.terminateLowReward = cfg.terminate_low_reward
+        pcfg.stuckTimeout = cfg.stuck_timeout
+
+        self.pool = pd.SimulatorPool()
+        self.pool.init(pcfg)
+
+        if cfg.car_model in cfg.car_tunes:
+            for name, value in cfg.car_tunes[cfg.car_model].items():
+                self.pool.setCarTune(name, value)
+
+        for name, value in cfg.scoring_vars.items():
+            self.pool.setScoringVar(name, value)
+
+        # layout follows SimulatorPool::packObservation, counts come from sim.ini [CAR_LOOK_AHEAD] and [CAR_PROBE_N]
+        obs_low, obs_high = ProjectDEnv._get_obs_space(cfg, self.pool.getLookAheadCount(), self.pool.getProbeCount(), self.pool.getProfileCount())
+        assert obs_low.shape[0] == self.pool.getObservationSize()
+        a_low, a_high = ProjectDEnv._get_action_space(cfg)
+
+        observation_space = gym_spaces.Box(low=obs_low, high=obs_high, dtype=np.float32)
+        action_space = gym_spaces.Box(low=a_low, high=a_high, dtype=np.float32)
+
+        super().__init__(num_envs, observation_space, action_space)
+
+        # columns follow CarControls: steer, clutch, brake, handBrake, gas
+        self.controls = np.zeros((num_envs, 5), dtype=np.float32)
+        if not cfg.auto_clutch:
+            self.controls[:, 1] = 1.0
+
+        self.actions = None
+
+    def reset(self):
+        return self.pool.reset()
+
+    def step_async(self, actions):
+        self.actions = np.asarray(actions, dtype=np.float32)
+
+    def step_wait(self):
+        a = np.clip(self.actions, -1.0, 1.0)
+        self.controls[:, 0] = a[:, 0] # steer [-1, 1]
+        self.controls[:, 4] = (a[:, 1] + 1.0) * 0.5 * (self.cfg.max_gas - self.cfg.min_gas) + self.cfg.min_gas
+
+        obs, rewards, dones, terminal_obs = self.pool.step(self.controls)
+
+        infos = [{} for _ in range(self.num_envs)]
+        for i in np.flatnonzero(dones):
+            infos[i]['terminal_observation'] = terminal_obs[i]
+
+        return obs, rewards, dones, infos
+
+    def close(self):
+        self.pool = None
+
+    def get_attr(self, attr_name, indices=None):
+        return [getattr(self.cfg, attr_name)] * len(self._get_indices(indices))
+
+    def set_attr(self, attr_name, value, indices=None):
+        raise NotImplementedError('settings are shared by all simulators of the pool')
+
+    def env_method(self, method_name, *method_args, indices=None, **method_kwargs):
+        raise NotImplementedError()
+
+    def env_is_wrapped(self, wrapper_class, indices=None):
+        return [False] * len(self._get_indices(indices))
+
+    def _get_indices(self, indices):
+        if indices is None:
+            return range(self.num_envs)
+        if isinstance(indices, int):
+            return [indices]
+        return indices
@@ -125,13 +125,13 @@ void PlaygrounD::renderStats()
 	if (sim_)
 	{
 		#if 1
-		if (sim_->interopEnabled && sim_->interopInput && sim_->interopState)
+		if (sim_->interopEnabled && sim_->interopInputRing.isValid() && sim_->interopStateRing.isValid())
 		{
-			auto* header = (SimInteropHeader*)sim_->interopInput->data();
-			font_.draw(x, y, "interopInput %llu / %llu", header->producerId, header->consumerId); y += dy;
+			auto* header = sim_->interopInputRing.header;
+			font_.draw(x, y, "interopInput %llu / %llu", (unsigned long long)header->writeIndex, (unsigned long long)header->readIndex); y += dy;
 
-			header = (SimInteropHeader*)sim_->interopState->data();
-			font_.draw(x, y, "interopState %llu / %llu", header->producerId, header->consumerId); y += dy;
+			header = sim_->interopStateRing.header;
+			font_.draw(x, y, "interopState %llu / %llu dropped %llu", (unsigned long long)header->writeIndex, (unsigned long long)header->readIndex, (unsigned long long)header->droppedFrames); y += dy;
 		}
 		#endif
 
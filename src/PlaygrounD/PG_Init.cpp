@@ -94,10 +94,6 @@ void PlaygrounD::initEngine(const std::wstring& basePath, bool loadedByPython)
 		SetDefaultDllDirectories(LOAD_LIBRARY_SEARCH_DEFAULT_DIRS);
 		AddDllDirectory(osCombinePath(appDir_, L"bin").c_str());
 	}
-	else
-	{
-		srand(666);
-	}
 
 	#if defined(DEBUG)
 	INIReader::_debug = true;
@@ -189,6 +185,10 @@ void PlaygrounD::setSimulator(SimulatorPtr newSim)
 		if (!sim_->avatar)
 			sim_->avatar.reset(new GLSimulator(sim_.get()));
 
+		// collision points are rendered and cleared every frame
+		if (!sim_->maxDbgCollisions)
+			sim_->maxDbgCollisions = 500;
+
 		auto* track = sim_->track.get();
 
 		if (track && !track->pits.empty())
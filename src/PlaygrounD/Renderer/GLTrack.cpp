@@ -11,6 +11,7 @@ GLTrack::GLTrack(Track* _track)
 	track = _track;
 
 	vec3f color;
+	Random rng(666);
 
 	{ GLCompileScoped compile(trackBatch);
 		for (auto& s : track->surfaces)
@@ -20,11 +21,11 @@ GLTrack::GLTrack(Track* _track)
 				if (s->isValidTrack)
 				{
 					//color = rgb(128, 128, 128) + randV(-32, 32) / 255.0f;
-					color = rgb(0, 60, 100) + randV(-30, 30) / 255.0f;
+					color = rgb(0, 60, 100) + randV(rng, -30, 30) / 255.0f;
 				}
 				else
 				{
-					color = rgb(0, 80, 00) + randV(-30, 30) / 255.0f;
+					color = rgb(0, 80, 00) + randV(rng, -30, 30) / 255.0f;
 				}
 
 				glColor3fv(&color.x);
@@ -38,7 +39,7 @@ GLTrack::GLTrack(Track* _track)
 		{
 			if (s->collisionCategory == C_CATEGORY_WALL)
 			{
-				color = rgb(160, 60, 0) + randV(-50, 50) / 255.0f;
+				color = rgb(160, 60, 0) + randV(rng, -50, 50) / 255.0f;
 				glColor3fv(&color.x);
 				glxTriMesh(s->trimesh.get());
 			}
@@ -174,8 +175,7 @@ void GLTrack::draw()
 
 	if (drawNearbyPoints)
 	{
-		nearbyPoints.clear();
-		track->fatPointsHash.queryNeighbours(camPos, nearbyPoints);
+		track->fatPointsGrid.query(camPos, 0.0f, nearbyPoints);
 
 		glPointSize(10);
 		glBegin(GL_POINTS);
@@ -187,7 +187,7 @@ void GLTrack::draw()
 		}
 		glEnd();
 
-		const float obstacleDist = track->rayCastTrackBounds(camPos, camDir);
+		const float obstacleDist = track->rayCastTrackBounds(boundsCache, camPos, camDir);
 		if (obstacleDist > 0.0f)
 		{
 			const auto interPos = camPos + camDir * obstacleDist;
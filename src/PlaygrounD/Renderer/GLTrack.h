@@ -22,7 +22,8 @@ struct GLTrack : public IAvatar
 	GLDisplayList trackBatch;
 	GLDisplayList wallsBatch;
 	GLDisplayList fatPointsBatch;
-	std::vector<size_t> nearbyPoints;
+	std::vector<uint32_t> nearbyPoints;
+	TrackPointCache boundsCache;
 	bool wireframe = false;
 	bool drawFatPoints = false;
 	bool drawNearbyPoints = false;
@@ -1,6 +1,8 @@
 #include "Car/CarImpl.h"
 #include "Sim/Simulator.h"
 #include "Sim/Track.h"
+#include "Car/WingDynamicController.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -36,6 +38,7 @@ bool Car::init(const std::wstring& modelName)
 
 	auto& pCore = sim->physics;
 	body = pCore->createRigidBody();
+	body->setUserPointer(this);
 	fuelTankBody = pCore->createRigidBody();
 
 	unixName = modelName;
@@ -85,18 +88,21 @@ bool Car::init(const std::wstring& modelName)
 		{
 			eSuspType = SuspensionType::Strut;
 			auto pImpl = new SuspensionStrut(); pSusp.reset(pImpl);
+			pImpl->damageData.damageDirection = randDamageDirection(sim->rng);
 			pImpl->init(pCore, body, index, carDataPath);
 		}
 		else if (strSuspType == L"DWB")
 		{
 			eSuspType = SuspensionType::DoubleWishbone;
 			auto pImpl = new SuspensionDW(); pSusp.reset(pImpl);
+			pImpl->damageData.damageDirection = randDamageDirection(sim->rng);
 			pImpl->init(pCore, body, antirollBars[0].get(), antirollBars[1].get(), index, carDataPath);
 		}
 		else if (strSuspType == L"ML")
 		{
 			eSuspType = SuspensionType::Multilink;
 			auto pImpl = new SuspensionML(); pSusp.reset(pImpl);
+			pImpl->damageData.damageDirection = randDamageDirection(sim->rng);
 			pImpl->init(pCore, body, index, carDataPath);
 		}
 		else if (strSuspType == L"AXLE" && index >= 2)
@@ -210,7 +216,8 @@ bool Car::init(const std::wstring& modelName)
 	setup.reset(new SetupManager());
 	setup->init(this);
 
-	state.reset(new CarState());
+	ownState.reset(new CarState());
+	state = ownState.get();
 
 	updateBodyMass();
 
@@ -308,9 +315,15 @@ void Car::initLookAhead()
 	{
 		ini->tryGetInt(L"CAR_LOOK_AHEAD", L"COUNT", lookAheadCount);
 		ini->tryGetFloat(L"CAR_LOOK_AHEAD", L"STEP", lookAheadStep);
+		ini->tryGetInt(L"CAR_LOOK_AHEAD", L"PROFILE_COUNT", lookAheadProfileCount);
+		ini->tryGetFloat(L"CAR_LOOK_AHEAD", L"PROFILE_STEP", lookAheadProfileStep);
 	}
 
 	lookAhead.resize(lookAheadCount);
+	lookAheadProfile.resize(lookAheadProfileCount);
+	lookAheadProfileOffsets.resize(lookAheadProfileCount);
+	for (int i = 0; i < lookAheadProfileCount; ++i)
+		lookAheadProfileOffsets[i] = lookAheadProfileStep * (float)(i + 1);
 }
 
 //=============================================================================
@@ -337,7 +350,7 @@ void Car::loadColliderBlob()
 	auto mesh = sim->physics->createTriMesh();
 	mesh->resize(raw.numVertices, raw.numIndices);
 	GUARD_FATAL(fread(mesh->getVB(), raw.numVertices * sizeof(TriMeshVertex), 1, file.fd) == 1);
-	GUARD_FATAL(fread(mesh->getIB(), raw.numIndices * sizeof(TriMeshIndex), 1, file.fd) == 1);
+	GUARD_FATAL(readTriMeshIndices(file.fd, mesh->getIB(), raw.numIndices, false));
 
 	auto gm = getGraphicsOffsetMatrix();
 	initColliderMesh(mesh, gm);
@@ -396,6 +409,7 @@ void Car::reset()
 	nearestTrackPointId = 0;
 	oldTrackPointId = 0;
 	splinePointId = 0;
+	trackLocator.valid = 0;
 
 	trackLocation = 0;
 	oldTrackLocation = 0;
@@ -721,18 +735,23 @@ void Car::updateTrackLocator(float dt)
 	{
 		if (probeHits.size() != numRays)
 			probeHits.resize(numRays);
+		if (probeRays.size() != numRays)
+			probeRays.resize(numRays);
 
 		for (size_t rayId = 0; rayId < numRays; ++rayId)
 		{
 			const auto& r = probes[rayId];
 			const auto rayStart = body->localToWorld(r.pos);
 			const auto rayEnd = body->localToWorld(r.pos + r.dir * r.length);
-			probeHits[rayId] = track->rayCastTrackBounds(rayStart, (rayEnd - rayStart).get_norm(), r.length);
+			probeRays[rayId] = ray3f(rayStart, (rayEnd - rayStart).get_norm(), r.length);
 		}
+
+		track->rayCastTrackBounds(trackPointCache, probeRays.data(), numRays, probeHits.data());
 	}
 
 	const auto bodyPos = body->getPosition(0);
-	const int bestPoint = (int)track->getPointIdAtLocation(bodyPos);
+	const bool located = track->updateLocator(trackLocator, bodyPos);
+	const int bestPoint = located ? trackLocator.pointId : 0;
 
 	if (nearestTrackPointId != bestPoint)
 	{
@@ -744,17 +763,11 @@ void Car::updateTrackLocator(float dt)
 	oldTrackLocation = trackLocation;
 	trackLocation = 0;
 
-	const int numPoints = (int)track->fatPoints.size();
-	if (bestPoint >= 0 && bestPoint < numPoints)
+	if (located)
 	{
-		Spline3dPointInfo info;
-		//trackLocation = tclamp((float)bestPoint / (float)numTrackPoints, 0.0f, 1.0f); // TODO: compute accurate location
-		if (track->getDistanceAlongSplineAtLocation(bodyPos, bestPoint, info))
-		{
-			splinePointId = info.id;
-			trackLocation = tclamp(info.dist / track->computedTrackLength, 0.0f, 1.0f);
-			worldSplinePosition = info.pos;
-		}
+		splinePointId = trackLocator.nodeId;
+		trackLocation = tclamp(trackLocator.distance / track->computedTrackLength, 0.0f, 1.0f);
+		worldSplinePosition = trackLocator.splinePos;
 
 		const auto bodyR = body->getWorldMatrix(0).getRotator();
 		const auto bodyFrontDir = (vec3f(0, 0, 1) * bodyR).get_norm();
@@ -777,26 +790,50 @@ void Car::updateLookAhead()
 	if (lookAhead.size() != (size_t)lookAheadCount)
 		lookAhead.resize((size_t)lookAheadCount);
 
-	const vec3f up(0, 1, 0);
-	const vec3f curTrackDir = track->getTrackDirectionAtDistance(trackLocation);
+	const auto& profile = track->profile;
+	if (!profile.isValid())
+	{
+		std::fill(lookAhead.begin(), lookAhead.end(), 0.0f);
+		std::fill(lookAheadProfile.begin(), lookAheadProfile.end(), TrackProfileSample());
+		return;
+	}
+
+	const float distance = trackLocator.valid ? trackLocator.distance : 0.0f;
+	const auto cur = profile.sample(distance);
 
 	const auto bodyR = body->getWorldMatrix(0).getRotator();
 	const auto bodyFrontDir = (vec3f(0, 0, 1) * bodyR).get_norm();
 
 	// is car driving in the right direction?
-	const float driveDir = signf(bodyFrontDir * curTrackDir);
+	lookAheadDir = signf(bodyFrontDir * vec3f(sinf(cur.heading), 0, cosf(cur.heading)));
 
+	// track direction change by arc length
 	for (int i = 0; i < lookAheadCount; ++i)
 	{
-		const float distanceNorm = trackLocation + ((lookAheadStep * (float)(i + 1)) / track->computedTrackLength) * driveDir;
-		const vec3f dir = track->getTrackDirectionAtDistance(distanceNorm);
+		const auto ahead = profile.sample(distance + lookAheadStep * (float)(i + 1) * lookAheadDir);
+		lookAhead[i] = wrapAngle(cur.heading - ahead.heading);
+	}
+
+	if (!lookAheadProfile.empty())
+	{
+		sampleTrackProfile(lookAheadProfileOffsets.data(), lookAheadProfile.size(), lookAheadProfile.data());
 
-		const float angle = atan2f(dir.cross(curTrackDir) * up, curTrackDir * dir);
-		lookAhead[i] = angle;
-		//lookAhead[i] = linscalef(angle, -M_PI, M_PI, -1.0f, 1.0f);
+		for (auto& s : lookAheadProfile)
+		{
+			s.heading = wrapAngle(s.heading - cur.heading);
+			s.elevation -= cur.elevation;
+		}
 	}
 }
 
+void Car::sampleTrackProfile(const float* offsets, size_t count, TrackProfileSample* out) const
+{
+	const float distance = trackLocator.valid ? trackLocator.distance : 0.0f;
+
+	for (size_t i = 0; i < count; ++i)
+		out[i] = track->profile.sample(distance + offsets[i] * lookAheadDir);
+}
+
 //=============================================================================
 
 void Car::updateCarState()
@@ -864,6 +901,17 @@ void Car::updateCarState()
 	#endif
 }
 
+void Car::bindState(CarState* storage)
+{
+	// external storage must outlive binding, nullptr restores own storage
+	auto* newState = storage ? storage : ownState.get();
+	if (newState != state)
+	{
+		*newState = *state;
+		state = newState;
+	}
+}
+
 //=============================================================================
 
 void Car::updateSensei()
@@ -918,6 +966,15 @@ void Car::updateSensei()
 // COLLISION
 //=============================================================================
 
+void Car::onCollisionBatch(const CollisionEvent* events, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto& ev = events[i];
+		onCollisionCallback(ev.rb0, ev.shape0, ev.rb1, ev.shape1, ev.normal, ev.pos, ev.depth);
+	}
+}
+
 void Car::onCollisionCallback(
 	void* userData0, void* shape0, 
 	void* userData1, void* shape1, 
@@ -1352,7 +1409,7 @@ void Car::teleportByMode(TeleportMode mode)
 			break;
 
 		case TeleportMode::Random:
-			teleportToSpline(randR(0.0f, 1.0f));
+			teleportToSpline(randR(sim->rng, 0.0f, 1.0f));
 			break;
 	}
 }
@@ -1483,4 +1540,128 @@ float Car::getBetaRad() const // TODO: check
 	return asinf(vel.x);
 }
 
+//=============================================================================
+
+void Car::serializeState(StateArchive& ar)
+{
+	ar.marker(0x20524143); // CAR
+
+	ar.io(controls);
+	ar.io(finalSteerAngleSignal);
+	ar.io(lockControls);
+	ar.io(smoothSteerTarget);
+	ar.io(smoothSteerValue);
+
+	ar.io(speed);
+	ar.io(lastVelocity);
+	ar.io(accG);
+	ar.io(fuel);
+
+	ar.io(lastBodyMassUpdateTime);
+	ar.io(lastCollisionTime);
+	ar.io(lastCollisionWithCarTime);
+	ar.io(damageZoneLevel);
+	ar.io(oldDamageZoneLevel);
+	ar.io(collisionFlag);
+	ar.io(oldCollisionFlag);
+	ar.io(outOfTrackFlag);
+	ar.io(framesToSleep);
+	ar.io(sleepingFrames);
+
+	ar.io(vibrationPhase);
+	ar.io(slipVibrationPhase);
+	ar.io(mzCurrent);
+	ar.io(flatSpotPhase);
+	ar.io(lastSteerPosition);
+	ar.io(lastPureMZFF);
+	ar.io(lastGyroFF);
+	ar.io(lastFF);
+	ar.io(lastDamp);
+	ar.io(lastVibr);
+
+	ar.io(probeHits.data(), probeHits.size() * sizeof(float));
+	ar.io(lookAhead.data(), lookAhead.size() * sizeof(float));
+	ar.io(lookAheadProfile.data(), lookAheadProfile.size() * sizeof(TrackProfileSample));
+	ar.io(lookAheadDir);
+
+	ar.io(lastTrackPointTimestamp);
+	ar.io(nearestTrackPointId);
+	ar.io(oldTrackPointId);
+	ar.io(splinePointId);
+	ar.io(trackLocation);
+	ar.io(oldTrackLocation);
+	ar.io(bodyVsTrack);
+	ar.io(velocityVsTrack);
+	ar.io(worldSplinePosition);
+	ar.io(senseiLapStarted);
+
+	// rayCastTrackBounds cache affects results
+	uint32_t numCachedPoints = (uint32_t)trackPointCache.points.size();
+	ar.io(trackPointCache.pos);
+	ar.io(trackPointCache.radius);
+	ar.io(numCachedPoints);
+	trackPointCache.points.resize(numCachedPoints);
+	ar.io(trackPointCache.points.data(), numCachedPoints * sizeof(uint32_t));
+	if (ar.isLoading())
+		track->initPointCacheSegments(trackPointCache);
+	ar.io(trackLocator);
+
+	ar.marker(0x50535553); // SUSP
+	for (auto& susp : suspensionsImpl)
+		susp->serializeState(ar);
+	for (auto& hs : heaveSprings)
+		ar.io(hs->status);
+
+	ar.marker(0x45525954); // TYRE
+	for (auto& tyre : tyres)
+		tyre->serializeState(ar);
+
+	ar.marker(0x56495244); // DRIV
+	drivetrain->serializeState(ar);
+
+	ar.io(gearChanger->wasGearUpTriggered);
+	ar.io(gearChanger->wasGearDnTriggered);
+	ar.io(gearChanger->lastGearUp);
+	ar.io(gearChanger->lastGearDn);
+
+	ar.io(autoClutch->clutchSequence.currentTime);
+	ar.io(autoClutch->clutchSequence.isDone);
+	ar.io(autoClutch->clutchValueSignal);
+	ar.io(autoClutch->isForced);
+
+	ar.io(autoShift->butGearUp);
+	ar.io(autoShift->butGearDn);
+
+	ar.io(autoBlip->blipStartTime);
+	ar.io(autoBlip->blipPerformTime);
+
+	ar.marker(0x4B415242); // BRAK
+	for (auto& disc : brakeSystem->discs)
+		ar.io(disc.t);
+	brakeSystem->ebbController.serializeState(ar);
+	brakeSystem->steerBrake.controller.serializeState(ar);
+	ar.io(brakeSystem->brakeOverride);
+	ar.io(brakeSystem->biasOverride);
+	ar.io(brakeSystem->ebbInstant);
+	ar.io(brakeSystem->rearCorrectionTorque);
+
+	ar.io(water->heatAccumulator);
+	ar.io(water->t);
+
+	ar.marker(0x4F524541); // AERO
+	for (auto& wing : aeroMap->wings)
+	{
+		ar.io(wing->status);
+		for (auto& wdc : wing->dynamicControllers)
+			ar.io(wdc->outputAngle);
+	}
+	ar.io(aeroMap->dynamicCD);
+	ar.io(aeroMap->dynamicCL);
+
+	ar.marker(0x524F4353); // SCOR
+	scoring->serializeState(ar);
+
+	ar.io(*state);
+}
+
 }
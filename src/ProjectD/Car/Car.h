@@ -6,6 +6,8 @@
 #include "Car/ISuspension.h"
 #include "Car/CarSenseiData.h"
 #include "Core/Event.h"
+#include "Sim/TrackLocator.h"
+#include "Sim/TrackProfile.h"
 
 namespace D {
 
@@ -74,10 +76,13 @@ struct Car : public virtual IObject
 	void updateLookAhead();
 	void postStep(float dt);
 	void updateCarState();
+	void bindState(CarState* storage);
 	void updateSensei();
+	void serializeState(StateArchive& ar);
 
 	// collision
 	void onCollisionCallback(void* userData0, void* shape0, void* userData1, void* shape1, const vec3f& normal, const vec3f& pos, float depth);
+	void onCollisionBatch(const CollisionEvent* events, size_t count);
 
 	// controls
 	void pollControls(float dt);
@@ -91,6 +96,7 @@ struct Car : public virtual IObject
 	void teleportToPits(int pitId);
 	void teleportToSpline(float distanceNorm);
 	void teleportByMode(TeleportMode mode);
+	void sampleTrackProfile(const float* offsets, size_t count, TrackProfileSample* out) const; // offsets in meters along driving direction
 	float getBaseCarHeight() const;
 	vec3f getGroundWindVector() const;
 	float getPointGroundHeight(const vec3f& pt) const;
@@ -180,7 +186,8 @@ struct Car : public virtual IObject
 	std::unique_ptr<AutoShifter> autoShift;
 	std::unique_ptr<ScoringSystem> scoring;
 	std::unique_ptr<SetupManager> setup;
-	std::unique_ptr<CarState> state;
+	std::unique_ptr<CarState> ownState;
+	CarState* state = nullptr; // points to ownState or external storage (see bindState)
 	std::unique_ptr<IAvatar> avatar;
 
 	CarControls controls;
@@ -204,6 +211,9 @@ struct Car : public virtual IObject
 	float damageZoneLevel[5] = {};
 	float oldDamageZoneLevel[5] = {};
 	bool collisionFlag = false;
+	TrackPointCache trackPointCache; // probes of this car
+	TrackLocator trackLocator;
+	std::vector<CollisionEvent> pendingCollisions; // contacts of current collision step, see Simulator::onCollisionStepCompleted
 	bool oldCollisionFlag = false;
 	bool outOfTrackFlag = false;
 
@@ -224,12 +234,20 @@ struct Car : public virtual IObject
 
 	// obstacle probes
 	std::vector<ray3f> probes;
+	std::vector<ray3f> probeRays; // world space
 	std::vector<float> probeHits;
 
 	// track curvature
 	std::vector<float> lookAhead;
 	int lookAheadCount = 5;
 	float lookAheadStep = 10.0;
+	float lookAheadDir = 1.0f; // driving along (1) or against (-1) track direction
+
+	// track features ahead, heading and elevation relative to current track position
+	std::vector<TrackProfileSample> lookAheadProfile;
+	std::vector<float> lookAheadProfileOffsets;
+	int lookAheadProfileCount = 0;
+	float lookAheadProfileStep = 10.0f;
 
 	float lastTrackPointTimestamp = 0;
 	int nearestTrackPointId = 0;
@@ -6,6 +6,7 @@
 #include "Car/ITorqueGenerator.h"
 #include "Car/ICoastGenerator.h"
 #include "Sim/Simulator.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -739,4 +740,39 @@ bool Drivetrain::isChangingGear() const
 	return gearRequest.request != GearChangeRequest::eNoGearRequest;
 }
 
+void Drivetrain::serializeState(StateArchive& ar)
+{
+	ar.io(gearRequest);
+
+	ar.io(engine);
+	ar.io(drive);
+	ar.io(outShaftL);
+	ar.io(outShaftR);
+	ar.io(outShaftLF);
+	ar.io(outShaftRF);
+
+	DynamicController* dynControllers[] = {
+		controllers.singleDiffLock.get(), controllers.awdFrontShare.get(), controllers.awdCenterLock.get(), controllers.awd2.get()
+	};
+	for (auto* dc : dynControllers)
+	{
+		if (dc)
+			dc->serializeState(ar);
+	}
+
+	ar.io(locClutch);
+	ar.io(currentClutchTorque);
+	ar.io(ratio);
+	ar.io(lastRatio);
+	ar.io(cutOff);
+	ar.io(rootVelocity);
+	ar.io(totalTorque);
+	ar.io(awdFrontShare);
+	ar.io(currentGear);
+	ar.io(isGearGrinding);
+	ar.io(clutchOpenState);
+
+	engineModel->serializeState(ar);
+}
+
 }
@@ -90,6 +90,7 @@ struct Drivetrain : public NonCopyable
 	float getEngineRPM() const;
 	float getDrivetrainSpeed() const;
 	bool isChangingGear() const;
+	void serializeState(StateArchive& ar);
 
 	// config
 	TractionType tractionType = TractionType(0);
@@ -2,6 +2,7 @@
 #include "Car/Car.h"
 #include "Car/Drivetrain.h"
 #include "Car/Tyre.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -273,4 +274,10 @@ float DynamicController::getRearSpeedRatio(Car* car)
 	return result;
 }
 
+void DynamicController::serializeState(StateArchive& ar)
+{
+	for (auto& stage : stages)
+		ar.io(stage->currentValue);
+}
+
 }
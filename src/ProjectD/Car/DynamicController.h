@@ -7,6 +7,7 @@
 namespace D {
 
 struct Car;
+struct StateArchive;
 
 enum class DynamicControllerVariable
 {
@@ -70,6 +71,7 @@ struct DynamicController : public NonCopyable
 	float getInput(DynamicControllerVariable input);
 	static float getOversteerFactor(Car* car);
 	static float getRearSpeedRatio(Car* car);
+	void serializeState(StateArchive& ar);
 
 	// config
 	std::vector<std::unique_ptr<DynamicControllerStage>> stages;
@@ -4,6 +4,7 @@
 #include "Car/ITorqueGenerator.h"
 #include "Car/ICoastGenerator.h"
 #include "Sim/Simulator.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -413,4 +414,29 @@ int Engine::getLimiterRPM() const
 	return (int)(data.limiter * limiterMultiplier);
 }
 
+void Engine::serializeState(StateArchive& ar)
+{
+	ar.io(lastInput);
+	ar.io(status);
+
+	ar.io(restrictor);
+	ar.io(fuelPressure);
+	ar.io(gasCoastOffset);
+	ar.io(electronicOverride);
+	ar.io(lifeLeft);
+	ar.io(gasUsage);
+	ar.io(bov);
+	ar.io(limiterOn);
+	ar.io(maxPowerW_Dynamic);
+
+	for (auto& turbo : turbos)
+	{
+		ar.io(turbo->userSetting);
+		ar.io(turbo->rotation);
+	}
+
+	for (auto& tc : turboControllers)
+		tc->controller.serializeState(ar);
+}
+
 }
@@ -57,6 +57,7 @@ struct Engine : public NonCopyable
 	void setCoastSettings(int id);
 	void blowUp();
 	int getLimiterRPM() const;
+	void serializeState(StateArchive& ar);
 
 	// config|engine
 	EngineData data;
@@ -4,6 +4,7 @@
 #include "Car/Drivetrain.h"
 #include "Car/Engine.h"
 #include "Sim/Track.h"
+#include "Core/StateArchive.h"
 
 #define DECL_VAR(name)\
 	static const std::string Name_##name (#name)
@@ -397,4 +398,24 @@ bool ScoringSystem::checkExtremeDrift(float triggerSlipLevel) const
 	return nDriftyTyres > 1;
 }
 
+void ScoringSystem::serializeState(StateArchive& ar)
+{
+	ar.io(drifting);
+	ar.io(driftExtreme);
+	ar.io(driftInvalid);
+	ar.io(currentDriftAngle);
+	ar.io(currentSpeedMultiplier);
+	ar.io(lastDriftDirection);
+	ar.io(driftStraightTimer);
+	ar.io(instantDriftDelta);
+	ar.io(instantDrift);
+	ar.io(driftPoints);
+	ar.io(driftComboCounter);
+	ar.io(stepReward);
+	ar.io(totalReward);
+	ar.io(prevEpisodeReward);
+	ar.io(oldPointId);
+	ar.io(oldSplinePointId);
+}
+
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Core/Core.h"
+#include <string>
 #include <vector>
 #include <unordered_map>
 
@@ -44,6 +45,7 @@ struct ScoringSystem
 	void resetDrift();
 	void validateDrift();
 	bool checkExtremeDrift(float triggerSlipLevel = 0.8f) const;
+	void serializeState(struct StateArchive& ar);
 
 	inline float getVar(const std::string& name) const { return config->getVar(name); }
 
@@ -1,6 +1,7 @@
 #include "Car/SetupManager.h"
 #include "Car/CarImpl.h"
 #include <fstream>
+#include <filesystem>
 
 namespace D {
 
@@ -411,7 +412,7 @@ std::vector<SetupGearRatio> SetupGearRatio::load(const std::wstring& filename)
 {
 	std::vector<SetupGearRatio> res;
 
-	std::wifstream file(filename);
+	std::wifstream file(std::filesystem::path{filename});
 	if (!file.is_open())
 	{
 		log_printf(L"File not found: %s", filename.c_str());
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Core/Core.h"
+#include <string>
+#include <cfloat>
 #include <vector>
 #include <unordered_map>
 
@@ -1,4 +1,5 @@
 #include "Car/SuspensionAxle.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -277,4 +278,9 @@ void SuspensionAxle::getDebugState(CarDebug* state)
 	}
 }
 
+void SuspensionAxle::serializeState(StateArchive& ar)
+{
+	ar.io(status);
+}
+
 }
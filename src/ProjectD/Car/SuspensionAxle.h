@@ -48,6 +48,7 @@ struct SuspensionAxle : public SuspensionBase
 	float getMass() override;
 	float getSteerTorque() override;
 	void getDebugState(CarDebug* state) override;
+	void serializeState(StateArchive& ar) override;
 
 	// config
 	std::vector<AxleJoint> joints;
@@ -23,6 +23,8 @@ struct SuspensionBase : public ISuspension
 	SuspensionStatus getStatus() const override { return status; }
 	Damper* getDamper() override { return &damper; }
 
+	virtual void serializeState(StateArchive& ar) = 0;
+
 	// config
 	SuspensionType type = SuspensionType(0);
 	int index = 0;
@@ -45,9 +47,9 @@ struct SuspensionBase : public ISuspension
 	SuspensionStatus status;
 };
 
-inline float randDamageDirection()
+inline float randDamageDirection(Random& rng)
 {
-	float fRnd = ((rand() * 0.000030518509f) * 100.0f);
+	float fRnd = rng.nextFloat() * 100.0f;
 	return (fRnd >= 50.0f) ? 1.0f : -1.0f;
 }
 
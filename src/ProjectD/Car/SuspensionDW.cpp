@@ -1,5 +1,6 @@
 #include "Car/SuspensionDW.h"
 #include "Car/AntirollBar.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -8,7 +9,6 @@ SuspensionDW::SuspensionDW()
 	k = 90000.0f;
 	baseCFM = 0.0000001f;
 	damageData.minVelocity = 15.0f;
-	damageData.damageDirection = randDamageDirection();
 }
 
 SuspensionDW::~SuspensionDW()
@@ -378,4 +378,13 @@ void SuspensionDW::getDebugState(CarDebug* state)
 {
 }
 
+void SuspensionDW::serializeState(StateArchive& ar)
+{
+	ar.io(status);
+	ar.io(damageData);
+	ar.io(activeActuator);
+	ar.io(steerTorque);
+	ar.io(steerAngle);
+}
+
 }
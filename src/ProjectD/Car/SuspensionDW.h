@@ -52,6 +52,7 @@ struct SuspensionDW : public SuspensionBase
 	float getMass() override;
 	float getSteerTorque() override;
 	void getDebugState(CarDebug* state) override;
+	void serializeState(StateArchive& ar) override;
 
 	// config
 	SuspensionDamage damageData;
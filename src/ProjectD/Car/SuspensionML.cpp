@@ -1,4 +1,5 @@
 #include "Car/SuspensionML.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -6,7 +7,6 @@ SuspensionML::SuspensionML()
 {
 	baseCFM = 0.0000001f;
 	damageData.minVelocity = 15.0f;
-	damageData.damageDirection = randDamageDirection();
 }
 
 SuspensionML::~SuspensionML()
@@ -233,4 +233,11 @@ void SuspensionML::getDebugState(CarDebug* state)
 {
 }
 
+void SuspensionML::serializeState(StateArchive& ar)
+{
+	ar.io(status);
+	ar.io(damageData);
+	ar.io(steerTorque);
+}
+
 }
@@ -42,6 +42,7 @@ struct SuspensionML : public SuspensionBase
 	float getMass() override;
 	float getSteerTorque() override;
 	void getDebugState(CarDebug* state) override;
+	void serializeState(StateArchive& ar) override;
 
 	// config
 	std::vector<MLJoint> joints;
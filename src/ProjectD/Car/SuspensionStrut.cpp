@@ -1,4 +1,5 @@
 #include "Car/SuspensionStrut.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -7,7 +8,6 @@ SuspensionStrut::SuspensionStrut()
 	k = 90000.0f;
 	baseCFM = 0.0000001f;
 	damageData.minVelocity = 15.0f;
-	damageData.damageDirection = randDamageDirection();
 }
 
 SuspensionStrut::~SuspensionStrut()
@@ -431,4 +431,12 @@ void SuspensionStrut::getDebugState(CarDebug* state)
 	});
 }
 
+void SuspensionStrut::serializeState(StateArchive& ar)
+{
+	ar.io(status);
+	ar.io(damageData);
+	ar.io(steerTorque);
+	ar.io(steerAngle);
+}
+
 }
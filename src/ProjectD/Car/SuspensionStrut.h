@@ -44,6 +44,7 @@ struct SuspensionStrut : public SuspensionBase
 	float getMass() override;
 	float getSteerTorque() override;
 	void getDebugState(CarDebug* state) override;
+	void serializeState(StateArchive& ar) override;
 
 	// config
 	SuspensionDamage damageData;
@@ -9,6 +9,7 @@
 #include "Sim/Track.h"
 
 #include "TyreUtils.inl"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -38,7 +39,7 @@ void Tyre::init(Car* _car, ISuspension* _hub, ITrackRayCastProvider* _rayCastPro
 	tyreModel.reset(new SCTM());
 	thermalModel.reset(new TyreThermalModel());
 	thermalModel->init(car, 12, 3);
-	rayCaster = rayCastProvider->createRayCaster(3.0f);
+	rayCaster = rayCastProvider->createRayCaster(contactRayLength);
 
 	initCompounds(dataPath);
 	setCompound(0);
@@ -478,7 +479,19 @@ void Tyre::step(float dt)
 		vec3f vRayPos(vWorldPos.x, vWorldPos.y + 2.0f, vWorldPos.z);
 		vec3f vRayDir(0.0f, -1.0f, 0.0f);
 
-		if (rayCaster)
+		if (hasBatchHit && batchRayPos.x == vRayPos.x && batchRayPos.y == vRayPos.y && batchRayPos.z == vRayPos.z)
+		{
+			bHasContact = batchHit.hasContact;
+
+			if (bHasContact)
+			{
+				vHitPos = batchHit.pos;
+				vHitNorm = batchHit.normal;
+				pCollisionObject = batchHit.collisionObject;
+				pSurface = batchHit.surface;
+			}
+		}
+		else if (rayCaster)
 		{
 			RayCastHit hit = rayCaster->rayCast(vRayPos, vRayDir);
 			bHasContact = hit.hasContact;
@@ -488,7 +501,7 @@ void Tyre::step(float dt)
 				vHitPos = hit.pos;
 				vHitNorm = hit.normal;
 				pCollisionObject = (ICollisionObject*)hit.collisionObject;
-				pSurface = (Surface*)pCollisionObject->getUserPointer();
+				pSurface = pCollisionProvider->getHitSurface(hit);
 			}
 		}
 		else
@@ -507,6 +520,8 @@ void Tyre::step(float dt)
 		}
 	}
 
+	hasBatchHit = false;
+
 	float fTest = 0;
 
 	if (!bHasContact || mxWorld.M22 <= 0.35f)
@@ -658,6 +673,21 @@ LB_COMPUTE_TORQ:
 		onStepCompleted();
 }
 
+void Tyre::getContactRay(vec3f& pos, vec3f& dir) const
+{
+	// same ray as in step()
+	const mat44f mxWorld = hub->getHubWorldMatrix();
+	pos = vec3f(mxWorld.M41, mxWorld.M42 + 2.0f, mxWorld.M43);
+	dir = vec3f(0.0f, -1.0f, 0.0f);
+}
+
+void Tyre::setBatchContact(const vec3f& rayPos, const TrackRayCastHit& hit)
+{
+	batchRayPos = rayPos;
+	batchHit = hit;
+	hasBatchHit = true;
+}
+
 void Tyre::addGroundContact(const vec3f& pos, const vec3f& normal)
 {
 	vec3f vOffset = worldPosition - pos;
@@ -977,4 +1007,59 @@ float Tyre::getDX(float load)
 	return fResult;
 }
 
+void Tyre::serializeState(StateArchive& ar)
+{
+	// surface is stored as index into track surfaces
+	int32_t surfaceIndex = -1;
+	if (ar.isSaving() && surfaceDef)
+	{
+		const auto& surfaces = car->track->surfaces;
+		for (size_t i = 0; i < surfaces.size(); ++i)
+		{
+			if (surfaces[i].get() == surfaceDef)
+			{
+				surfaceIndex = (int32_t)i;
+				break;
+			}
+		}
+	}
+
+	ar.io(surfaceIndex);
+
+	if (ar.isLoading())
+	{
+		const auto& surfaces = car->track->surfaces;
+		GUARD_FATAL(surfaceIndex < (int32_t)surfaces.size());
+		surfaceDef = (surfaceIndex >= 0 ? surfaces[surfaceIndex].get() : nullptr);
+	}
+
+	ar.io(inputs);
+	ar.io(externalInputs);
+	ar.io(status);
+	ar.io(shakeGenerator);
+
+	ar.io(worldRotation);
+	ar.io(localWheelRotation);
+	ar.io(worldPosition);
+	ar.io(roadHeading);
+	ar.io(roadRight);
+	ar.io(unmodifiedContactPoint);
+	ar.io(contactPoint);
+	ar.io(contactNormal);
+
+	ar.io(absOverride);
+	ar.io(slidingVelocityX);
+	ar.io(slidingVelocityY);
+	ar.io(rSlidingVelocityX);
+	ar.io(rSlidingVelocityY);
+	ar.io(roadVelocityX);
+	ar.io(roadVelocityY);
+	ar.io(totalHubVelocity);
+	ar.io(totalSlideVelocity);
+	ar.io(oldAngularVelocity);
+	ar.io(localMX);
+
+	thermalModel->serializeState(ar);
+}
+
 }
@@ -33,6 +33,8 @@ struct Tyre : public NonCopyable
 	void reset();
 
 	void step(float dt);
+	void getContactRay(vec3f& pos, vec3f& dir) const;
+	void setBatchContact(const vec3f& rayPos, const TrackRayCastHit& hit);
 	void addGroundContact(const vec3f& pos, const vec3f& normal);
 	void updateLockedState(float dt);
 	void updateAngularSpeed(float dt);
@@ -47,6 +49,7 @@ struct Tyre : public NonCopyable
 	void stepDirtyLevel(float dt, float hubSpeed);
 	void stepPuncture(float dt, float hubSpeed);
 	void addTyreForceToHub(const vec3f& pos, const vec3f& force);
+	void serializeState(StateArchive& ar);
 
 	// utils
 	float getDX(float load);
@@ -65,6 +68,7 @@ struct Tyre : public NonCopyable
 	bool driven = false;
 	bool tyreBlanketsOn = false;
 	bool useLoadForVKM = false;
+	float contactRayLength = 3.0f;
 
 	// runtime
 	Car* car = nullptr;
@@ -74,6 +78,12 @@ struct Tyre : public NonCopyable
 	IRayCasterPtr rayCaster;
 	Surface* surfaceDef = nullptr;
 
+	// contact resolved by Simulator::stepCars batch, used if ray origin still matches
+	TrackRayCastHit batchHit;
+	vec3f batchRayPos;
+	bool hasBatchHit = false;
+	TrackContactCache contactCache; // geometry only, not part of serialized state
+
 	std::unique_ptr<SCTM> tyreModel;
 	std::unique_ptr<TyreThermalModel> thermalModel;
 
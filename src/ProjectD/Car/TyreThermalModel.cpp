@@ -1,6 +1,7 @@
 #include "Car/TyreThermalModel.h"
 #include "Car/Car.h"
 #include "Sim/Simulator.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -209,4 +210,19 @@ void TyreThermalModel::reset()
 	phase = 0;
 }
 
+void TyreThermalModel::serializeState(StateArchive& ar)
+{
+	for (auto& patch : patches)
+	{
+		ar.io(patch.inputT);
+		ar.io(patch.T);
+	}
+
+	ar.io(phase);
+	ar.io(coreTInput);
+	ar.io(coreTemp);
+	ar.io(practicalTemp);
+	ar.io(thermalMultD);
+}
+
 }
@@ -30,6 +30,7 @@ struct TyreThermalModel : public NonCopyable
 	float getAvgSurfaceTemp();
 	void setTemperature(float optimumTemp);
 	void reset();
+	void serializeState(StateArchive& ar);
 
 	// config
 	bool isActive = true;
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <algorithm>
 
 #define STRINGIZE_W2(x) L ## x
 #define STRINGIZE_W(x) STRINGIZE_W2(#x)
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace D {
+
+// Functions using AVX2 intrinsics are compiled for AVX2 individually and must only be called when cpuHasAvx2().
+// MSVC accepts the intrinsics without /arch, GCC/Clang need the target attribute.
+#if defined(_MSC_VER)
+	#define D_TARGET_AVX2
+#else
+	#define D_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+bool cpuHasAvx2();
+
+}
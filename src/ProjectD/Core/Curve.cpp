@@ -2,6 +2,7 @@
 #include "Core/String.h"
 #include "Core/Diag.h"
 #include <fstream>
+#include <filesystem>
 
 namespace D {
 
@@ -131,7 +132,7 @@ bool Curve::load(const std::wstring& filename)
 
 	reset();
 
-	std::wifstream file(filename);
+	std::wifstream file(std::filesystem::path{filename});
 	if (!file.is_open())
 	{
 		SHOULD_NOT_REACH_WARN;
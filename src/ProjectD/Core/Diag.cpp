@@ -19,11 +19,8 @@ void log_clear_file()
 {
 	if (!_logFileName.empty())
 	{
-		FILE* fd = nullptr;
-		if (_wfopen_s(&fd, _logFileName.c_str(), L"wt") == 0 && fd)
-		{
-			fclose(fd);
-		}
+		FileHandle file;
+		file.open(_logFileName.c_str(), L"wt");
 	}
 }
 
@@ -46,12 +43,11 @@ void log_printf(const wchar_t* format, ...)
 
 		if (!_logFileName.empty())
 		{
-			FILE* fd = nullptr;
-			if (_wfopen_s(&fd, _logFileName.c_str(), L"at") == 0 && fd)
+			FileHandle file;
+			if (file.open(_logFileName.c_str(), L"at"))
 			{
-				fputws(line.c_str(), fd);
-				fputwc(L'\n', fd);
-				fclose(fd);
+				fputws(line.c_str(), file.fd);
+				fputwc(L'\n', file.fd);
 			}
 		}
 	}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <xmmintrin.h>
+
+namespace D {
+
+// Pins SSE control word for the scope: round to nearest, exceptions masked, denormals flushed to zero.
+struct FloatModeGuard
+{
+	static const unsigned int DeterministicCsr = 0x9FC0; // FTZ | DAZ | all exception masks
+
+	inline explicit FloatModeGuard(bool enable) : enabled(enable)
+	{
+		if (enabled)
+		{
+			savedCsr = _mm_getcsr();
+			_mm_setcsr(DeterministicCsr);
+		}
+	}
+
+	inline ~FloatModeGuard()
+	{
+		if (enabled)
+			_mm_setcsr(savedCsr);
+	}
+
+	unsigned int savedCsr = 0;
+	bool enabled = false;
+};
+
+}
@@ -4,6 +4,7 @@
 #include "Core/OS.h"
 #include <sstream>
 #include <fstream>
+#include <filesystem>
 
 namespace D {
 
@@ -47,7 +48,7 @@ bool INIReader::load(const std::wstring& filename)
 	auto iter = _iniCache.find(filename);
 	if (iter == _iniCache.end()) // not cached
 	{
-		std::wifstream fs(filename);
+		std::wifstream fs(std::filesystem::path{filename});
 		if (!fs.is_open())
 		{
 			SHOULD_NOT_REACH_WARN;
@@ -0,0 +1,149 @@
+#include "Core/MappedFile.h"
+#include "Core/Diag.h"
+
+#ifdef _WINDOWS
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+namespace D {
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const wchar_t* filename)
+{
+	close();
+
+	// share delete: file can be replaced by rename while mapped (cooked track packages)
+	HANDLE file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	fileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mappingHandle = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mappingHandle)
+	{
+		log_printf(L"ERROR: CreateFileMapping failed: code=0x%X", GetLastError());
+		close();
+		return false;
+	}
+
+	dataPtr = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (!dataPtr)
+	{
+		log_printf(L"ERROR: MapViewOfFile failed: code=0x%X", GetLastError());
+		close();
+		return false;
+	}
+
+	dataSize = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (dataPtr)
+	{
+		UnmapViewOfFile(dataPtr);
+		dataPtr = nullptr;
+		dataSize = 0;
+	}
+
+	if (mappingHandle)
+	{
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+
+	if (fileHandle)
+	{
+		CloseHandle(fileHandle);
+		fileHandle = nullptr;
+	}
+}
+
+}
+
+#else // NOT _WINDOWS
+
+#include "Core/String.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace D {
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const wchar_t* filename)
+{
+	close();
+
+	fileFd = ::open(stra(filename).c_str(), O_RDONLY);
+	if (fileFd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fileFd, &st) != 0 || st.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileFd, 0);
+	if (ptr == MAP_FAILED)
+	{
+		log_printf(L"ERROR: mmap failed: errno=%d", errno);
+		close();
+		return false;
+	}
+
+	dataPtr = ptr;
+	dataSize = (size_t)st.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (dataPtr)
+	{
+		munmap(dataPtr, dataSize);
+		dataPtr = nullptr;
+		dataSize = 0;
+	}
+
+	if (fileFd >= 0)
+	{
+		::close(fileFd);
+		fileFd = -1;
+	}
+}
+
+}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+namespace D {
+
+// Read-only memory mapped file, pages are loaded on first access.
+struct MappedFile
+{
+	MappedFile();
+	~MappedFile();
+
+	bool open(const wchar_t* filename);
+	void close();
+
+	inline bool isValid() const { return dataPtr ? true : false; }
+	inline const void* data() const { return dataPtr; }
+	inline size_t size() const { return dataSize; }
+
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	void* dataPtr = nullptr;
+	size_t dataSize = 0;
+
+	// POSIX
+	int fileFd = -1;
+};
+
+}
@@ -1,13 +1,17 @@
 #include "Core/Math.h"
-#include <DirectXMath.h>
 #include <cstring>
 
+#if defined(_WINDOWS)
+#include <DirectXMath.h>
 using namespace DirectX;
+#endif
 
 namespace D {
 
+#if defined(_WINDOWS)
 inline XMMATRIX xmload(const mat44f& m) { return XMMATRIX(&m.M11); }
 inline mat44f xmstore(const XMMATRIX& m) { XMFLOAT4X4 f44; XMStoreFloat4x4(&f44, m); return *(mat44f*)&f44._11; }
+#endif
 
 plane4f::plane4f(const vec3f& p1, const vec3f& p2, const vec3f& p3)
 {
@@ -119,8 +123,20 @@ mat44f mat44f::createFromAxisAngle(const vec3f& axis, float angle)
 
 mat44f mat44f::mult(const mat44f& a, const mat44f& b)
 {
+#if defined(_WINDOWS)
 	auto res = XMMatrixMultiply(xmload(a), xmload(b));
 	return xmstore(res);
+#else
+	mat44f res;
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			res.dim2[i][j] = a.dim2[i][0] * b.dim2[0][j] + a.dim2[i][1] * b.dim2[1][j] + a.dim2[i][2] * b.dim2[2][j] + a.dim2[i][3] * b.dim2[3][j];
+		}
+	}
+	return res;
+#endif
 }
 
 mat44f mat44f::rotate(const mat44f& m, const vec3f& axis, float angle)
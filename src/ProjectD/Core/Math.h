@@ -1,8 +1,15 @@
 #pragma once
 
 #include "Core/Core.h"
+#include "Core/Random.h"
 #include <cmath>
+#include <cfloat>
+
+#if defined(_MSC_VER)
 #include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
 
 #if !defined(M_PI)
 #define M_PI 3.1415926535897932384626433832795f
@@ -13,6 +20,8 @@
 
 namespace D {
 
+using std::isfinite;
+
 // thanks UE!
 #if 1
 inline int truncToInt(float F) { return _mm_cvtt_ss2si(_mm_set_ss(F)); }
@@ -37,6 +46,9 @@ inline T tclamp(const T& x, const T& a, const T& b) { return (x < a ? a : (x > b
 
 inline float signf(const float x) { return (x > 0.0f) ? 1.0f : ((x < 0.0f) ? -1.0f : 0.0f); }
 
+// to [-PI, PI]
+inline float wrapAngle(float a) { return a - (2.0f * M_PI) * floorf((a + M_PI) / (2.0f * M_PI)); }
+
 inline float linscalef(float x, float x0, float x1, float r0, float r1) {
 	x = tclamp(x, x0, x1);
 	return ((r1 - r0) * (x - x0)) / (x1 - x0) + r0;
@@ -46,9 +58,8 @@ inline float sawToothWave(float v, float p) {
 	return ((v - ((v / p) * p)) - (p * 0.5f)) / (p * 0.5f);
 }
 
-inline float randR(float min, float max) {
-	float r = (float)rand() / (float)RAND_MAX;
-	return min + r * (max - min);
+inline float randR(Random& rng, float min, float max) {
+	return min + rng.nextFloat() * (max - min);
 }
 
 struct vec2f
@@ -206,8 +217,8 @@ inline vec3f operator*(const vec3f& v, const mat44f& m)
 	);
 }
 
-inline vec3f randV(float min, float max) {
-	return vec3f(randR(min, max), randR(min, max), randR(min, max));
+inline vec3f randV(Random& rng, float min, float max) {
+	return vec3f(randR(rng, min, max), randR(rng, min, max), randR(rng, min, max));
 }
 
 inline vec3f rgb(int r, int g, int b) {
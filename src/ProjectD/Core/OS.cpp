@@ -90,36 +90,6 @@ std::wstring osCombinePath(const std::wstring& a, const std::wstring& b)
 	return std::wstring();
 }
 
-std::wstring osGetDirPath(const std::wstring& path)
-{
-	std::wstring res;
-	const int len = (int)path.length();
-	for (int i = len - 1; i >= 0; --i)
-	{
-		if (path[i] == L'\\' || path[i] == L'/')
-		{
-			res = path.substr(0, (size_t)i + 1);
-			break;
-		}
-	}
-	return res;
-}
-
-std::wstring osGetFileName(const std::wstring& path)
-{
-	std::wstring res;
-	const int len = (int)path.length();
-	for (int i = len - 1; i >= 0; --i)
-	{
-		if (path[i] == L'\\' || path[i] == L'/')
-		{
-			res = path.substr((size_t)i + 1);
-			break;
-		}
-	}
-	return res;
-}
-
 bool osFileExists(const std::wstring& path)
 {
 	DWORD dwAttrib = GetFileAttributesW(path.c_str());
@@ -140,17 +110,6 @@ void osEnsureDirExists(const std::wstring& path)
 	}
 }
 
-void osCreateDirectoryTree(const std::wstring& path)
-{
-	std::wstring::size_type pos = 0;
-	do
-	{
-		pos = path.find_first_of(L"\\/", pos + 1);
-		osEnsureDirExists(path.substr(0, pos).c_str());
-	}
-	while (pos != std::wstring::npos);
-}
-
 struct OSFindWindowData
 {
 	LPCWSTR ClassName = nullptr;
@@ -220,6 +179,182 @@ bool FileHandle::open(const wchar_t* filename, const wchar_t* mode)
 	return (err == 0);
 }
 
+
+}
+
+#else // NOT _WINDOWS
+
+#include <unistd.h>
+#include <dlfcn.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#include <filesystem>
+
+namespace D {
+
+void osTraceDebug(const wchar_t* msg)
+{
+	// no debugger output channel, log_printf already writes to stdout
+}
+
+unsigned int osGetCurrentProcessId()
+{
+	return (unsigned int)getpid();
+}
+
+unsigned int osGetCurrentThreadId()
+{
+	return (unsigned int)syscall(SYS_gettid);
+}
+
+unsigned int osGetCurrentTicks()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned int)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+}
+
+void* osLoadLibraryA(const char* path)
+{
+	return dlopen(path, RTLD_NOW);
+}
+
+void* osLoadLibraryW(const wchar_t* path)
+{
+	return dlopen(stra(path).c_str(), RTLD_NOW);
+}
+
+void* osGetProcAddress(void* lib, const char* name)
+{
+	return dlsym(lib, name);
+}
+
+std::wstring osGetModuleFullPath()
+{
+	char buf[PATH_MAX];
+	const ssize_t n = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+	return (n > 0) ? strw(std::string(buf, (size_t)n)) : std::wstring();
+}
+
+std::wstring osGetCurrentDir()
+{
+	char buf[PATH_MAX]; buf[0] = 0;
+	return getcwd(buf, sizeof(buf)) ? strw(buf) : std::wstring();
+}
+
+void osSetCurrentDir(const std::wstring& path)
+{
+	if (chdir(stra(path).c_str()) != 0)
+	{
+		auto msg = strwf(L"chdir failed: err=%d", errno);
+		osTraceDebug(msg.c_str());
+	}
+}
+
+std::wstring osCanonicPath(const std::wstring& path)
+{
+	// lexical like PathCchCanonicalize, file system is not touched
+	return strw(std::filesystem::path(stra(path)).lexically_normal().string());
+}
+
+std::wstring osCombinePath(const std::wstring& a, const std::wstring& b)
+{
+	return strw((std::filesystem::path(stra(a)) / std::filesystem::path(stra(b))).lexically_normal().string());
+}
+
+bool osFileExists(const std::wstring& path)
+{
+	struct stat st;
+	return (stat(stra(path).c_str(), &st) == 0 && S_ISREG(st.st_mode));
+}
+
+bool osDirExists(const std::wstring& path)
+{
+	struct stat st;
+	return (stat(stra(path).c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+}
+
+void osEnsureDirExists(const std::wstring& path)
+{
+	if (!osDirExists(path.c_str()))
+	{
+		mkdir(stra(path).c_str(), 0755);
+	}
+}
+
+void* osFindWindow(const wchar_t* ClassName, const wchar_t* Title)
+{
+	return nullptr;
+}
+
+void* osFindProcessWindow(unsigned int ProcessId)
+{
+	return nullptr;
+}
+
+bool FileHandle::open(const wchar_t* filename, const wchar_t* mode)
+{
+	close();
+
+	std::string modeA(stra(mode));
+	modeA.erase(std::remove(modeA.begin(), modeA.end(), 't'), modeA.end()); // text mode is default
+
+	fd = fopen(stra(filename).c_str(), modeA.c_str());
+	return (fd != nullptr);
+}
+
+}
+
+#endif
+
+//=============================================================================
+
+namespace D {
+
+std::wstring osGetDirPath(const std::wstring& path)
+{
+	std::wstring res;
+	const int len = (int)path.length();
+	for (int i = len - 1; i >= 0; --i)
+	{
+		if (path[i] == L'\\' || path[i] == L'/')
+		{
+			res = path.substr(0, (size_t)i + 1);
+			break;
+		}
+	}
+	return res;
+}
+
+std::wstring osGetFileName(const std::wstring& path)
+{
+	std::wstring res;
+	const int len = (int)path.length();
+	for (int i = len - 1; i >= 0; --i)
+	{
+		if (path[i] == L'\\' || path[i] == L'/')
+		{
+			res = path.substr((size_t)i + 1);
+			break;
+		}
+	}
+	return res;
+}
+
+void osCreateDirectoryTree(const std::wstring& path)
+{
+	std::wstring::size_type pos = 0;
+	do
+	{
+		pos = path.find_first_of(L"\\/", pos + 1);
+		osEnsureDirExists(path.substr(0, pos).c_str());
+	}
+	while (pos != std::wstring::npos);
+}
+
 void FileHandle::close()
 {
 	if (fd)
@@ -243,8 +378,3 @@ size_t FileHandle::size() const
 
 }
 
-#else // NOT _WINDOWS
-
-#error "Platform not supported"
-
-#endif
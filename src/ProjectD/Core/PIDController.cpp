@@ -13,7 +13,7 @@ float PIDController::eval(float targetv, float currentv, float dt)
 
 	float fValue = (((fErr - currentError) / dt) * D) + ((fIntegral * I) + (fErr * P));
 
-	if (isfinite(fErr) && isfinite(fIntegral) && isfinite(fValue))
+	if (std::isfinite(fErr) && std::isfinite(fIntegral) && std::isfinite(fValue))
 	{
 		return fValue;
 	}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+namespace D {
+
+// PCG32 generator, state is plain data so it can be stored in snapshots.
+struct Random
+{
+	inline Random() { seed(0); }
+	inline explicit Random(uint64_t value) { seed(value); }
+
+	inline void seed(uint64_t value)
+	{
+		state = 0;
+		inc = (0xDA3E39CB94B95BDBull << 1u) | 1u;
+		next();
+		state += value;
+		next();
+	}
+
+	inline uint32_t next()
+	{
+		const uint64_t old = state;
+		state = old * 6364136223846793005ull + inc;
+		const uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+		const uint32_t rot = (uint32_t)(old >> 59u);
+		return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31u));
+	}
+
+	// [0, 1)
+	inline float nextFloat()
+	{
+		return (float)(next() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	uint64_t state = 0;
+	uint64_t inc = 0;
+};
+
+}
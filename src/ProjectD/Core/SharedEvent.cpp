@@ -0,0 +1,130 @@
+#include "Core/SharedEvent.h"
+#include "Core/Diag.h"
+
+#ifdef _WINDOWS
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+namespace D {
+
+SharedEvent::SharedEvent()
+{
+}
+
+SharedEvent::~SharedEvent()
+{
+	close();
+}
+
+void SharedEvent::create(const wchar_t* name, std::atomic<uint32_t>* word)
+{
+	close();
+
+	eventHandle = CreateEventW(NULL, FALSE, FALSE, name);
+	if (!eventHandle)
+	{
+		log_printf(L"ERROR: CreateEvent failed: code=0x%X", GetLastError());
+		return;
+	}
+
+	futexWord = word;
+}
+
+void SharedEvent::open(const wchar_t* name, std::atomic<uint32_t>* word)
+{
+	close();
+
+	eventHandle = OpenEventW(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, name);
+	if (!eventHandle)
+	{
+		log_printf(L"ERROR: OpenEvent failed: code=0x%X", GetLastError());
+		return;
+	}
+
+	futexWord = word;
+}
+
+void SharedEvent::close()
+{
+	if (eventHandle)
+	{
+		CloseHandle(eventHandle);
+		eventHandle = nullptr;
+	}
+
+	futexWord = nullptr;
+}
+
+void SharedEvent::signal()
+{
+	SetEvent(eventHandle);
+}
+
+bool SharedEvent::wait(uint32_t expectedWord, unsigned int timeoutMs)
+{
+	// event stays signaled until consumed, so a signal between the word check and the wait is not lost
+	if (futexWord->load(std::memory_order_acquire) != expectedWord)
+		return true;
+
+	return WaitForSingleObject(eventHandle, timeoutMs) == WAIT_OBJECT_0;
+}
+
+}
+
+#else // NOT _WINDOWS
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <cerrno>
+#include <ctime>
+
+namespace D {
+
+SharedEvent::SharedEvent()
+{
+}
+
+SharedEvent::~SharedEvent()
+{
+	close();
+}
+
+void SharedEvent::create(const wchar_t* name, std::atomic<uint32_t>* word)
+{
+	// futex is addressed by the shared word itself, no named object
+	futexWord = word;
+}
+
+void SharedEvent::open(const wchar_t* name, std::atomic<uint32_t>* word)
+{
+	futexWord = word;
+}
+
+void SharedEvent::close()
+{
+	futexWord = nullptr;
+}
+
+void SharedEvent::signal()
+{
+	// not FUTEX_PRIVATE_FLAG, waiters live in other processes
+	syscall(SYS_futex, (uint32_t*)futexWord, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+bool SharedEvent::wait(uint32_t expectedWord, unsigned int timeoutMs)
+{
+	timespec ts;
+	ts.tv_sec = (time_t)(timeoutMs / 1000u);
+	ts.tv_nsec = (long)(timeoutMs % 1000u) * 1000000L;
+
+	const long rc = syscall(SYS_futex, (uint32_t*)futexWord, FUTEX_WAIT, expectedWord, &ts, nullptr, 0);
+	return (rc == 0 || errno != ETIMEDOUT);
+}
+
+}
+
+#endif
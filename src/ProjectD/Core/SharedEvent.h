@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+namespace D {
+
+// Cross-process wakeup: named auto-reset event on Windows, futex on a shared 32-bit word on Linux.
+// Waiter passes the word value it observed, wait returns immediately if it has changed since.
+struct SharedEvent
+{
+	SharedEvent();
+	~SharedEvent();
+
+	void create(const wchar_t* name, std::atomic<uint32_t>* word);
+	void open(const wchar_t* name, std::atomic<uint32_t>* word);
+	void close();
+
+	inline bool isValid() const { return futexWord != nullptr; }
+
+	void signal();
+	bool wait(uint32_t expectedWord, unsigned int timeoutMs); // false on timeout
+
+	void* eventHandle = nullptr;
+	std::atomic<uint32_t>* futexWord = nullptr;
+};
+
+}
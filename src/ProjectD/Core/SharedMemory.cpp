@@ -79,6 +79,124 @@ void SharedMemory::close()
 
 #else // NOT _WINDOWS
 
-#error "Platform not supported"
+#include "Core/String.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace D {
+
+static std::string shmName(const wchar_t* name)
+{
+	// shm_open expects "/name" without other slashes
+	std::string res = "/" + stra(name);
+	for (size_t i = 1; i < res.size(); ++i)
+	{
+		if (res[i] == '/' || res[i] == '\\')
+			res[i] = '_';
+	}
+	return res;
+}
+
+SharedMemory::SharedMemory()
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+	close();
+}
+
+void SharedMemory::allocate(const wchar_t* name, size_t size)
+{
+	close();
+
+	const std::string id = shmName(name);
+	mappingFd = shm_open(id.c_str(), O_CREAT | O_RDWR, 0666);
+	if (mappingFd < 0)
+	{
+		log_printf(L"ERROR: shm_open failed: errno=%d", errno);
+		return;
+	}
+
+	isOwner = true;
+
+	if (ftruncate(mappingFd, (off_t)size) != 0)
+	{
+		log_printf(L"ERROR: ftruncate failed: errno=%d", errno);
+		close();
+		return;
+	}
+
+	void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mappingFd, 0);
+	if (ptr == MAP_FAILED)
+	{
+		log_printf(L"ERROR: mmap failed: errno=%d", errno);
+		close();
+		return;
+	}
+
+	dataPtr = ptr;
+	mappingSize = size;
+	mappingHandle = dataPtr;
+	memset(dataPtr, 0, size);
+
+	// keep the name alive for clients, unlinked in close()
+	mappingName = id;
+}
+
+void SharedMemory::open(const wchar_t* name, size_t size)
+{
+	close();
+
+	mappingFd = shm_open(shmName(name).c_str(), O_RDWR, 0666);
+	if (mappingFd < 0)
+	{
+		log_printf(L"ERROR: shm_open failed: errno=%d", errno);
+		return;
+	}
+
+	void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mappingFd, 0);
+	if (ptr == MAP_FAILED)
+	{
+		log_printf(L"ERROR: mmap failed: errno=%d", errno);
+		close();
+		return;
+	}
+
+	dataPtr = ptr;
+	mappingSize = size;
+	mappingHandle = dataPtr;
+}
+
+void SharedMemory::close()
+{
+	if (dataPtr)
+	{
+		munmap(dataPtr, mappingSize);
+		dataPtr = nullptr;
+		mappingSize = 0;
+	}
+
+	mappingHandle = nullptr;
+
+	if (mappingFd >= 0)
+	{
+		::close(mappingFd);
+		mappingFd = -1;
+	}
+
+	if (isOwner)
+	{
+		shm_unlink(mappingName.c_str());
+		mappingName.clear();
+		isOwner = false;
+	}
+}
+
+}
 
 #endif
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 namespace D {
 
 struct SharedMemory
@@ -16,6 +19,12 @@ struct SharedMemory
 
 	void* mappingHandle = nullptr;
 	void* dataPtr = nullptr;
+
+	// POSIX
+	std::string mappingName;
+	size_t mappingSize = 0;
+	int mappingFd = -1;
+	bool isOwner = false;
 };
 	
 }
@@ -1,6 +1,7 @@
 #include "Core/Spline3d.h"
 #include "Core/Diag.h"
 #include "Core/DebugGL.h"
+#include <algorithm>
 
 namespace D {
 
@@ -74,6 +75,36 @@ bool Spline3d::find_nearest_point(const vec3f& pos, Spline3dPointInfo& info, int
 	return found;
 }
 
+int Spline3d::node_at_length(float s, int hint) const
+{
+	const int npoints = (int)_distances.size();
+	if (!npoints)
+		return 0;
+
+	// walk from hint when it is close, otherwise binary search
+	const int max_walk = 16;
+	if (hint >= 0 && hint < npoints)
+	{
+		int id = hint;
+		for (int i = 0; i < max_walk; ++i)
+		{
+			if (id + 1 < npoints && _distances[id + 1] <= s)
+				++id;
+			else if (id > 0 && _distances[id] > s)
+				--id;
+			else
+				return (id + 1 < npoints && _distances[id + 1] - s < s - _distances[id]) ? id + 1 : id;
+		}
+	}
+
+	const int id = (int)(std::upper_bound(_distances.begin(), _distances.end(), s) - _distances.begin());
+	if (id <= 0)
+		return 0;
+	if (id >= npoints)
+		return npoints - 1;
+	return (_distances[id] - s < s - _distances[id - 1]) ? id : id - 1;
+}
+
 //=============================================================================
 
 void BSpline3d::init_from_array(std::vector<vec3f>& points, bool closed_loop)
@@ -161,4 +192,126 @@ vec3f BSpline3d::interpolate(float u, const vec3f& P0, const vec3f& P1, const ve
 	return point;
 } 
 
+//=============================================================================
+
+void ArcSpline3d::clear()
+{
+	_knots.clear();
+	_tangents.clear();
+	_length = 0;
+}
+
+void ArcSpline3d::init_from_spline(const Spline3d& spline, float step)
+{
+	clear();
+
+	const int nnodes = spline.node_count();
+	if (nnodes < 2 || step <= 0.0f)
+		return;
+
+	_closed_loop = spline._closed_loop;
+	_length = spline.total_length();
+
+	// closed loop knots are spread over [0, length) and wrap around, open spline keeps both ends
+	const int nseg = tmax(_closed_loop ? 4 : 1, roundToInt(_length / step));
+	const int nknots = _closed_loop ? nseg : nseg + 1;
+	_step = _length / (float)nseg;
+	_inv_step = 1.0f / _step;
+
+	_knots.resize(nknots);
+	int node = 0;
+	for (int k = 0; k < nknots; ++k)
+	{
+		const float s = (float)k * _step;
+		while (node + 2 < nnodes && spline.length_at_point(node + 1) <= s)
+			++node;
+
+		const float d0 = spline.length_at_point(node);
+		const float d1 = spline.length_at_point(node + 1);
+		const float u = (d1 > d0) ? tclamp((s - d0) / (d1 - d0), 0.0f, 1.0f) : 0.0f;
+		_knots[k] = spline.node(node) + (spline.node(node + 1) - spline.node(node)) * u;
+	}
+
+	_tangents.resize(nknots);
+	for (int k = 0; k < nknots; ++k)
+	{
+		int k0 = k - 1, k1 = k + 1;
+		if (_closed_loop)
+		{
+			if (k0 < 0) k0 = nknots - 1;
+			if (k1 >= nknots) k1 = 0;
+		}
+		else
+		{
+			k0 = tmax(k0, 0);
+			k1 = tmin(k1, nknots - 1);
+		}
+		_tangents[k] = (_knots[k1] - _knots[k0]) / ((float)(k1 - k0 == 1 ? 1 : 2) * _step);
+	}
+}
+
+float ArcSpline3d::wrap(float s) const
+{
+	if (_closed_loop)
+	{
+		s = fmodf(s, _length);
+		if (s < 0.0f)
+			s += _length;
+		return s;
+	}
+	return tclamp(s, 0.0f, _length);
+}
+
+void ArcSpline3d::eval(float s, vec3f* pos, vec3f* d1, vec3f* d2) const
+{
+	const int nknots = (int)_knots.size();
+	const int nseg = _closed_loop ? nknots : nknots - 1;
+
+	const float x = wrap(s) * _inv_step;
+	const int k = tclamp(floorToInt(x), 0, nseg - 1);
+	const int k1 = (k + 1 < nknots) ? k + 1 : 0;
+	const float t = tclamp(x - (float)k, 0.0f, 1.0f);
+	const float t2 = t * t, t3 = t2 * t;
+
+	const vec3f& p0 = _knots[k];
+	const vec3f& p1 = _knots[k1];
+	const vec3f m0 = _tangents[k] * _step;
+	const vec3f m1 = _tangents[k1] * _step;
+
+	if (pos)
+		*pos = p0 * (2 * t3 - 3 * t2 + 1) + m0 * (t3 - 2 * t2 + t) + p1 * (-2 * t3 + 3 * t2) + m1 * (t3 - t2);
+	if (d1)
+		*d1 = (p0 * (6 * t2 - 6 * t) + m0 * (3 * t2 - 4 * t + 1) + p1 * (-6 * t2 + 6 * t) + m1 * (3 * t2 - 2 * t)) * _inv_step;
+	if (d2)
+		*d2 = (p0 * (12 * t - 6) + m0 * (6 * t - 4) + p1 * (-12 * t + 6) + m1 * (6 * t - 2)) * (_inv_step * _inv_step);
+}
+
+float ArcSpline3d::project(const vec3f& pos, float s, int max_iter) const
+{
+	if (is_empty())
+		return 0.0f;
+
+	s = wrap(s);
+	for (int iter = 0; iter < max_iter; ++iter)
+	{
+		vec3f p, d1, d2;
+		eval(s, &p, &d1, &d2);
+
+		// minimize |p(s) - pos|^2, fall back to gauss-newton when curvature term makes it non convex
+		const vec3f r = p - pos;
+		const float f = d1 * r;
+		float fd = d1 * d1 + d2 * r;
+		if (fd < 1e-3f)
+			fd = tmax(d1 * d1, 1e-3f);
+
+		const float ds = tclamp(-f / fd, -_step, _step);
+		s = wrap(s + ds);
+
+		if (fabsf(ds) < 1e-4f)
+			break;
+	}
+
+	return s;
+}
+
 }
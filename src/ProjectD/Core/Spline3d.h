@@ -37,6 +37,8 @@ struct Spline3d
 	inline float total_length() const { return _distances[_distances.size() - 1]; }
 
 	inline void set_steps(int steps) { _steps = steps; }
+
+	int node_at_length(float s, int hint = -1) const;
 }; 
 
 struct BSpline3d : public Spline3d
@@ -48,4 +50,24 @@ struct BSpline3d : public Spline3d
 	vec3f interpolate(float u, const vec3f& P0, const vec3f& P1, const vec3f& P2, const vec3f& P3);
 }; 
 
+// Cubic Hermite spline through knots resampled at uniform arc length, parameter is distance along source spline.
+struct ArcSpline3d
+{
+	std::vector<vec3f> _knots;
+	std::vector<vec3f> _tangents; // d(pos)/ds
+	float _step = 1.0f;
+	float _inv_step = 1.0f;
+	float _length = 0;
+	bool _closed_loop = false;
+
+	void clear();
+	void init_from_spline(const Spline3d& spline, float step);
+	float wrap(float s) const;
+	void eval(float s, vec3f* pos, vec3f* d1 = nullptr, vec3f* d2 = nullptr) const;
+	float project(const vec3f& pos, float s, int max_iter = 8) const; // newton from initial guess s
+
+	inline bool is_empty() const { return _knots.size() < 2; }
+	inline float total_length() const { return _length; }
+};
+
 }
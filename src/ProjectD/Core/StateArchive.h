@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Core/Diag.h"
+#include <vector>
+#include <cstring>
+#include <type_traits>
+
+namespace D {
+
+// Flat binary snapshot of runtime state, same serializeState() code path is used to save and load.
+struct StateArchive : public NonCopyable
+{
+	// save
+	inline explicit StateArchive(std::vector<uint8_t>& buffer) : writeBuffer(&buffer)
+	{
+		writeBuffer->clear();
+	}
+
+	// load
+	inline StateArchive(const void* data, size_t size) : readData((const uint8_t*)data), readSize(size) {}
+
+	inline bool isSaving() const { return writeBuffer != nullptr; }
+	inline bool isLoading() const { return writeBuffer == nullptr; }
+
+	inline void io(void* data, size_t size)
+	{
+		if (writeBuffer)
+		{
+			const size_t offset = writeBuffer->size();
+			writeBuffer->resize(offset + size);
+			memcpy(writeBuffer->data() + offset, data, size);
+		}
+		else
+		{
+			GUARD_FATAL(pos + size <= readSize);
+			memcpy(data, readData + pos, size);
+		}
+		pos += size;
+	}
+
+	template<typename T>
+	inline void io(T& value)
+	{
+		// math types declare copy constructors, plain layout is enough for memcpy
+		static_assert(std::is_standard_layout<T>::value && !std::is_pointer<T>::value, "StateArchive: type is not plain data");
+		io(&value, sizeof(T));
+	}
+
+	template<typename T, size_t N>
+	inline void io(T (&values)[N])
+	{
+		for (size_t i = 0; i < N; ++i)
+			io(values[i]);
+	}
+
+	// writes tag on save, validates it on load
+	inline void marker(uint32_t tag)
+	{
+		uint32_t value = tag;
+		io(value);
+		GUARD_FATAL(value == tag);
+	}
+
+	inline bool isEof() const { return isLoading() && pos == readSize; }
+
+	std::vector<uint8_t>* writeBuffer = nullptr;
+	const uint8_t* readData = nullptr;
+	size_t readSize = 0;
+	size_t pos = 0;
+};
+
+// FNV-1a
+inline uint64_t hashStateBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+}
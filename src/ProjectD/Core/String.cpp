@@ -1,6 +1,9 @@
 #include "Core/String.h"
 #include <algorithm>
 #include <codecvt>
+#include <locale>
+#include <cwchar>
+#include <cwctype>
 
 namespace D {
 
@@ -58,6 +61,42 @@ std::string straf(const char* format, ...)
 	return str;
 }
 
+#ifndef _WINDOWS
+// sources use MSVC wide printf conventions: %s/%c take wide args, %S/%C narrow ones
+static std::wstring toPosixWideFormat(const wchar_t* format)
+{
+	std::wstring res;
+	for (const wchar_t* p = format; *p; ++p)
+	{
+		res.push_back(*p);
+		if (*p != L'%')
+			continue;
+
+		if (p[1] == L'%')
+		{
+			res.push_back(*++p);
+			continue;
+		}
+
+		bool hasLength = false;
+		while (p[1] && wcschr(L"-+ #0123456789.*hlLjzt", p[1]))
+		{
+			hasLength |= (wcschr(L"hlLjzt", p[1]) != nullptr);
+			res.push_back(*++p);
+		}
+
+		if (!p[1])
+			break;
+
+		const wchar_t conv = *++p;
+		if ((conv == L's' || conv == L'c') && !hasLength)
+			res.push_back(L'l');
+		res.push_back((conv == L'S' || conv == L'C') ? (wchar_t)towlower(conv) : conv);
+	}
+	return res;
+}
+#endif
+
 std::wstring strwfv(const wchar_t* format, va_list args)
 {
 	const size_t bufCount = 1024;
@@ -66,7 +105,14 @@ std::wstring strwfv(const wchar_t* format, va_list args)
 	#ifdef _WINDOWS
 		int n = _vsnwprintf_s(buf, bufCount, _TRUNCATE, format, args);
 	#else
-		int n = vswprintf(buf, bufCount, format, args);
+		const auto posixFormat = toPosixWideFormat(format);
+		buf[0] = 0;
+		int n = vswprintf(buf, bufCount, posixFormat.c_str(), args);
+		if (n < 0) // truncated
+		{
+			buf[bufCount - 1] = 0;
+			n = (int)wcslen(buf);
+		}
 	#endif
 
 	std::wstring str;
@@ -0,0 +1,161 @@
+#include "Core/ThreadPool.h"
+#include "Core/Diag.h"
+#include "Core/Math.h"
+#include <exception>
+
+namespace D {
+
+ThreadPool::ThreadPool(int numThreads)
+{
+	TRACE_CTOR(ThreadPool);
+
+	if (numThreads <= 0)
+		numThreads = (int)std::thread::hardware_concurrency();
+
+	numThreads = tclamp(numThreads, 1, 256);
+	log_printf(L"ThreadPool: numThreads=%d", numThreads);
+
+	for (int i = 0; i < numThreads; ++i)
+		queues.emplace_back(new TaskQueue());
+
+	// caller thread is the last worker
+	for (int i = 0; i < numThreads - 1; ++i)
+		threads.emplace_back([this, i]() { workerMain((size_t)i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	TRACE_DTOR(ThreadPool);
+
+	{
+		std::lock_guard<std::mutex> lock(mux);
+		exitFlag = true;
+	}
+	cvWork.notify_all();
+
+	for (auto& t : threads)
+		t.join();
+}
+
+void ThreadPool::parallelFor(size_t count, const TaskFunc& func)
+{
+	if (!count)
+		return;
+
+	if (threads.empty())
+	{
+		for (size_t i = 0; i < count; ++i)
+			func(i);
+		return;
+	}
+
+	std::exception_ptr firstError;
+	std::mutex errorMux;
+
+	TaskFunc guardedFunc = [&func, &firstError, &errorMux](size_t index)
+	{
+		try
+		{
+			func(index);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(errorMux);
+			if (!firstError)
+				firstError = std::current_exception();
+		}
+	};
+
+	const size_t numQueues = queues.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto* queue = queues[i % numQueues].get();
+		std::lock_guard<std::mutex> lock(queue->mux);
+		queue->tasks.push_back(i);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mux);
+		currentFunc = &guardedFunc;
+		pendingTasks = count;
+		busyWorkers = (int)threads.size();
+		++generation;
+	}
+	cvWork.notify_all();
+
+	runTasks(numQueues - 1);
+
+	{
+		std::unique_lock<std::mutex> lock(mux);
+		cvDone.wait(lock, [this]() { return busyWorkers == 0; });
+		currentFunc = nullptr;
+	}
+
+	if (firstError)
+		std::rethrow_exception(firstError);
+}
+
+void ThreadPool::workerMain(size_t queueId)
+{
+	uint64_t lastGeneration = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mux);
+			cvWork.wait(lock, [this, lastGeneration]() { return exitFlag || generation != lastGeneration; });
+			if (exitFlag)
+				break;
+			lastGeneration = generation;
+		}
+
+		runTasks(queueId);
+
+		{
+			std::lock_guard<std::mutex> lock(mux);
+			--busyWorkers;
+		}
+		cvDone.notify_one();
+	}
+}
+
+void ThreadPool::runTasks(size_t queueId)
+{
+	size_t task = 0;
+	while (pendingTasks > 0 && popTask(queueId, task))
+	{
+		(*currentFunc)(task);
+		--pendingTasks;
+	}
+}
+
+bool ThreadPool::popTask(size_t queueId, size_t& task)
+{
+	{
+		auto* queue = queues[queueId].get();
+		std::lock_guard<std::mutex> lock(queue->mux);
+		if (!queue->tasks.empty())
+		{
+			task = queue->tasks.front();
+			queue->tasks.pop_front();
+			return true;
+		}
+	}
+
+	const size_t numQueues = queues.size();
+	for (size_t i = 1; i < numQueues; ++i)
+	{
+		auto* victim = queues[(queueId + i) % numQueues].get();
+		std::lock_guard<std::mutex> lock(victim->mux);
+		if (!victim->tasks.empty())
+		{
+			task = victim->tasks.back();
+			victim->tasks.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Core/Core.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+namespace D {
+
+// Work-stealing pool: every thread owns a queue, idle threads steal from the back of other queues.
+struct ThreadPool : public NonCopyable
+{
+	using TaskFunc = std::function<void(size_t index)>;
+
+	ThreadPool(int numThreads = 0); // including caller thread, 0: hardware concurrency
+	~ThreadPool();
+
+	// runs func(index) for index in [0, count), caller thread participates, blocks until all tasks are done
+	// index i is initially queued to thread (i % numQueues) so repeated batches keep their affinity
+	void parallelFor(size_t count, const TaskFunc& func);
+
+	int getThreadCount() const { return (int)queues.size(); }
+
+	// internals
+
+	struct TaskQueue
+	{
+		std::mutex mux;
+		std::deque<size_t> tasks;
+	};
+
+	void workerMain(size_t queueId);
+	bool popTask(size_t queueId, size_t& task);
+	void runTasks(size_t queueId);
+
+	std::vector<std::thread> threads;
+	std::vector<std::unique_ptr<TaskQueue>> queues; // last queue belongs to caller thread
+
+	std::mutex mux;
+	std::condition_variable cvWork;
+	std::condition_variable cvDone;
+	const TaskFunc* currentFunc = nullptr;
+	uint64_t generation = 0;
+	std::atomic<size_t> pendingTasks = 0;
+	int busyWorkers = 0;
+	bool exitFlag = false;
+};
+
+}
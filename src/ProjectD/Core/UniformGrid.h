@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Core/Math.h"
+#include <vector>
+
+namespace D {
+
+// Flat 2D grid (XZ) over static points, CSR layout: items of cell c are items[cellStart[c] .. cellStart[c + 1]).
+// Cells are centered on multiples of cellSize, distance filter is 3D.
+struct UniformGrid
+{
+	float cellSize = 50;
+	float invCellSize = 1.0f / 50;
+	int minX = 0;
+	int minZ = 0;
+	int dimX = 0;
+	int dimZ = 0;
+	std::vector<uint32_t> cellStart; // dimX * dimZ + 1
+	std::vector<uint32_t> items; // point ids sorted by cell
+	std::vector<vec3f> itemPos; // positions in items order
+
+	inline bool isEmpty() const { return items.empty(); }
+
+	inline int cellCoord(float v) const { return roundToInt(v * invCellSize); }
+
+	void build(const vec3f* points, size_t count, float _cellSize)
+	{
+		cellSize = _cellSize;
+		invCellSize = 1.0f / _cellSize;
+		cellStart.clear();
+		items.clear();
+		itemPos.clear();
+		dimX = dimZ = 0;
+
+		if (!count)
+			return;
+
+		int maxX = minX = cellCoord(points[0].x);
+		int maxZ = minZ = cellCoord(points[0].z);
+		for (size_t i = 1; i < count; ++i)
+		{
+			const int x = cellCoord(points[i].x), z = cellCoord(points[i].z);
+			minX = tmin(minX, x); maxX = tmax(maxX, x);
+			minZ = tmin(minZ, z); maxZ = tmax(maxZ, z);
+		}
+
+		dimX = maxX - minX + 1;
+		dimZ = maxZ - minZ + 1;
+		cellStart.assign((size_t)dimX * (size_t)dimZ + 1, 0);
+
+		std::vector<uint32_t> pointCell(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			pointCell[i] = (uint32_t)((cellCoord(points[i].z) - minZ) * dimX + (cellCoord(points[i].x) - minX));
+			cellStart[pointCell[i] + 1]++;
+		}
+
+		for (size_t c = 1; c < cellStart.size(); ++c)
+			cellStart[c] += cellStart[c - 1];
+
+		// counting sort keeps point order inside cells
+		std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+		items.resize(count);
+		itemPos.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t slot = fill[pointCell[i]]++;
+			items[slot] = (uint32_t)i;
+			itemPos[slot] = points[i];
+		}
+	}
+
+	// writes ids of points closer than maxDistance (0: cellSize) to out, returns total number found which may exceed maxOut
+	size_t query(const vec3f& origin, float maxDistance, uint32_t* out, size_t maxOut) const
+	{
+		if (items.empty())
+			return 0;
+
+		if (maxDistance <= 0.0f)
+			maxDistance = cellSize;
+
+		const float maxDistanceSq = maxDistance * maxDistance;
+		const int r = tmax(1, ceilToInt(maxDistance * invCellSize));
+
+		const int cx = cellCoord(origin.x) - minX;
+		const int cz = cellCoord(origin.z) - minZ;
+		const int x0 = tmax(cx - r, 0), x1 = tmin(cx + r, dimX - 1);
+		const int z0 = tmax(cz - r, 0), z1 = tmin(cz + r, dimZ - 1);
+		if (x0 > x1 || z0 > z1)
+			return 0;
+
+		size_t n = 0;
+		for (int z = z0; z <= z1; ++z)
+		{
+			const size_t row = (size_t)z * (size_t)dimX;
+			const uint32_t first = cellStart[row + x0];
+			const uint32_t last = cellStart[row + x1 + 1]; // cells of a row are contiguous
+
+			for (uint32_t i = first; i < last; ++i)
+			{
+				if ((itemPos[i] - origin).sqlen() < maxDistanceSq)
+				{
+					if (n < maxOut)
+						out[n] = items[i];
+					n++;
+				}
+			}
+		}
+
+		return n;
+	}
+
+	// appends ids of points inside XZ rectangle
+	void queryRect(float minPx, float minPz, float maxPx, float maxPz, std::vector<uint32_t>& result) const
+	{
+		if (items.empty())
+			return;
+
+		const int x0 = tmax(cellCoord(minPx) - minX, 0), x1 = tmin(cellCoord(maxPx) - minX, dimX - 1);
+		const int z0 = tmax(cellCoord(minPz) - minZ, 0), z1 = tmin(cellCoord(maxPz) - minZ, dimZ - 1);
+		if (x0 > x1 || z0 > z1)
+			return;
+
+		for (int z = z0; z <= z1; ++z)
+		{
+			const size_t row = (size_t)z * (size_t)dimX;
+			for (uint32_t i = cellStart[row + x0], last = cellStart[row + x1 + 1]; i < last; ++i)
+			{
+				const auto& p = itemPos[i];
+				if (p.x >= minPx && p.x <= maxPx && p.z >= minPz && p.z <= maxPz)
+					result.push_back(items[i]);
+			}
+		}
+	}
+
+	inline void query(const vec3f& origin, float maxDistance, std::vector<uint32_t>& result) const
+	{
+		result.resize(result.capacity() ? result.capacity() : 64);
+		size_t n = query(origin, maxDistance, result.data(), result.size());
+		if (n > result.size())
+		{
+			result.resize(n);
+			n = query(origin, maxDistance, result.data(), result.size());
+		}
+		result.resize(n);
+	}
+};
+
+}
@@ -5,12 +5,26 @@
 
 namespace D {
 
+struct CollisionEvent
+{
+	IRigidBody* rb0;
+	ICollisionObject* shape0;
+	IRigidBody* rb1;
+	ICollisionObject* shape1;
+	vec3f normal;
+	vec3f pos;
+	float depth;
+};
+
 struct ICollisionCallback : public virtual IObject
 {
 	virtual void onCollisionCallback(
 		IRigidBody* rb0, ICollisionObject* shape0, 
 		IRigidBody* rb1, ICollisionObject* shape1, 
 		const vec3f& normal, const vec3f& pos, float depth) = 0;
+
+	// all contacts of the collision step were reported, called before the world step
+	virtual void onCollisionStepCompleted() = 0;
 };
 
 }
@@ -7,6 +7,52 @@
 
 namespace D {
 
+struct StateArchive;
+
+enum class CollisionSpaceType : int
+{
+	Simple = 0,
+	Hash,
+	QuadTree,
+	SweepAndPrune,
+};
+
+// broadphase of static (track surfaces, per sector sub-spaces) and dynamic (car bodies) geometry
+struct CollisionSpaceConfig
+{
+	CollisionSpaceType staticType = CollisionSpaceType::Simple;
+	CollisionSpaceType dynamicType = CollisionSpaceType::Simple;
+	int hashMinLevel = -3; // hash cell size 2^level
+	int hashMaxLevel = 10;
+	int quadTreeDepth = 6;
+	int carSweepAndPrune = 0; // car vs car pairs from persistent sweep and prune over box proxies of dynamic meshes, meshes are collided for overlapping proxies
+};
+
+struct PhysicsSolverConfig
+{
+	int quickStep = 0; // dWorldQuickStep instead of dWorldStep
+	int quickStepIterations = 48;
+	int numThreads = 0; // island worker threads, 0: solve on calling thread
+	int sharedThreadPool = 0; // one pool for all engines, their world steps are serialized
+	int maxPairContacts = 0; // contacts kept per geom pair and normal cluster, 0: keep all
+	float contactNormalCos = 0.95f; // contacts with closer normals share a cluster
+	int contactPoolSize = 256; // contact records reserved per group
+};
+
+inline bool parseCollisionSpaceType(const std::wstring& value, CollisionSpaceType& type)
+{
+	// INIReader keeps whitespace before inline comments
+	const auto first = value.find_first_not_of(L" \t\r");
+	const auto last = value.find_last_not_of(L" \t\r");
+	const std::wstring name = (first != std::wstring::npos) ? value.substr(first, last - first + 1) : std::wstring();
+
+	if (name == L"SIMPLE") { type = CollisionSpaceType::Simple; return true; }
+	if (name == L"HASH") { type = CollisionSpaceType::Hash; return true; }
+	if (name == L"QUADTREE") { type = CollisionSpaceType::QuadTree; return true; }
+	if (name == L"SAP") { type = CollisionSpaceType::SweepAndPrune; return true; }
+	return false;
+}
+
 struct IPhysicsEngine : public virtual IObject
 {
 	virtual IRigidBodyPtr createRigidBody() = 0;
@@ -21,10 +67,16 @@ struct IPhysicsEngine : public virtual IObject
 	virtual IRayCasterPtr createRayCaster(float length) = 0;
 
 	virtual void setCollisionCallback(ICollisionCallback* callback) = 0;
+	virtual void setCollisionSpaces(const CollisionSpaceConfig& config) = 0;
+	virtual void setWorldBounds(const vec3f& bmin, const vec3f& bmax) = 0; // quadtree spaces are sized once bounds are known
 	virtual RayCastHit rayCast(const vec3f& pos, const vec3f& dir, float length) = 0;
 	virtual RayCastHit rayCast(const vec3f& pos, const vec3f& dir, IRayCasterPtr ray) = 0;
 
+	virtual void initThread() = 0;
+	virtual void setDeterministic(bool value) = 0;
+	virtual void setSolverConfig(const PhysicsSolverConfig& config) = 0; // threads and QuickStep ignored while deterministic
 	virtual void step(float dt) = 0;
+	virtual void serializeState(StateArchive& ar) = 0;
 };
 
 DECL_SHARED_PTR(IPhysicsEngine);
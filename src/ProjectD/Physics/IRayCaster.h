@@ -7,6 +7,7 @@ namespace D {
 struct RayCastHit
 {
 	ICollisionObject* collisionObject = nullptr;
+	uint32_t triangle = 0; // in collisionObject mesh
 	vec3f pos;
 	vec3f normal;
 	bool hasContact = false;
@@ -15,6 +16,12 @@ struct RayCastHit
 struct IRayCaster : public virtual IObject
 {
 	virtual RayCastHit rayCast(const vec3f& pos, const vec3f& dir) = 0;
+
+	virtual void rayCastBatch(const vec3f* pos, const vec3f* dir, size_t count, RayCastHit* hits)
+	{
+		for (size_t i = 0; i < count; ++i)
+			hits[i] = rayCast(pos[i], dir[i]);
+	}
 };
 
 DECL_SHARED_PTR(IRayCaster);
@@ -6,6 +6,9 @@ namespace D {
 
 struct IRigidBody : public virtual IObject
 {
+	virtual void setUserPointer(void* data) = 0;
+	virtual void* getUserPointer() = 0;
+
 	virtual void setEnabled(bool value) = 0;
 	virtual bool isEnabled() = 0;
 	virtual void setAutoDisable(bool mode) = 0;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Physics/PhysicsCommon.h"
+#include <cstdio>
+#include <vector>
 
 namespace D {
 
@@ -9,11 +11,17 @@ struct TriMeshVertex
 	float x, y, z;
 };
 
+// must match dTriIndex of the linked ODE build
+#if defined(dTRIMESH_16BIT_INDICES)
 using TriMeshIndex = unsigned short;
+#else
+using TriMeshIndex = uint32_t;
+#endif
 
 struct ITriMesh : public virtual IObject
 {
 	virtual void resize(size_t vertexCount, size_t indexCount) = 0;
+	virtual void setView(const TriMeshVertex* vb, size_t vertexCount, const TriMeshIndex* ib, size_t indexCount) = 0; // read-only storage owned by caller, must outlive the mesh
 	virtual TriMeshVertex* getVB() = 0;
 	virtual size_t getVertexCount() = 0;
 	virtual TriMeshIndex* getIB() = 0;
@@ -22,4 +30,33 @@ struct ITriMesh : public virtual IObject
 
 DECL_SHARED_PTR(ITriMesh);
 
+// blob files store 16 or 32 bit indices independent of TriMeshIndex
+inline bool readTriMeshIndices(FILE* fd, TriMeshIndex* ib, size_t count, bool index32)
+{
+	if (sizeof(TriMeshIndex) == (index32 ? 4 : 2))
+		return fread(ib, count * sizeof(TriMeshIndex), 1, fd) == 1;
+
+	if (index32)
+	{
+		std::vector<uint32_t> tmp(count);
+		if (fread(tmp.data(), count * sizeof(uint32_t), 1, fd) != 1)
+			return false;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (tmp[i] > (TriMeshIndex)~(TriMeshIndex)0)
+				return false; // 32-bit blob needs ODE built without dTRIMESH_16BIT_INDICES
+			ib[i] = (TriMeshIndex)tmp[i];
+		}
+	}
+	else
+	{
+		std::vector<uint16_t> tmp(count);
+		if (fread(tmp.data(), count * sizeof(uint16_t), 1, fd) != 1)
+			return false;
+		for (size_t i = 0; i < count; ++i)
+			ib[i] = (TriMeshIndex)tmp[i];
+	}
+	return true;
+}
+
 }
@@ -15,7 +15,8 @@ CollisionMeshODE::CollisionMeshODE(
 	GUARD_FATAL(trimesh->getIndexCount() > 0);
 
 	int iVertexSize = 3 * sizeof(float);
-	int iIndexSize = sizeof(unsigned short);
+	static_assert(sizeof(TriMeshIndex) == sizeof(dTriIndex), "TriMeshIndex does not match ODE build");
+	int iIndexSize = sizeof(TriMeshIndex);
 	int iTriangleSize = 3 * iIndexSize;
 
 	geomTrimesh = ODE_CALL(dGeomTriMeshDataCreate)();
@@ -37,6 +38,12 @@ CollisionMeshODE::~CollisionMeshODE()
 {
 	//TRACE_DTOR(CollisionMeshODE);
 
+	if (proxy)
+	{
+		core->removeDynamicProxy(this);
+		ODE_CALL(dGeomDestroy)(proxy);
+	}
+
 	ODE_CALL(dGeomDestroy)(geom);
 	ODE_CALL(dGeomTriMeshDataDestroy)(geomTrimesh);
 }
@@ -19,6 +19,7 @@ struct CollisionMeshODE : public ICollisionObject, PhysicsChildODE
 	ITriMeshPtr trimesh;
 	dxTriMeshData* geomTrimesh = nullptr;
 	dxGeom* geom = nullptr;
+	dxGeom* proxy = nullptr; // bounding box of dynamic mesh, not in any space
 	void* userPointer = nullptr;
 };
 
@@ -4,18 +4,97 @@
 #include "Physics/ODE/JointODE.h"
 #include "Physics/ODE/RayCasterODE.h"
 #include "Physics/ODE/TriMeshODE.h"
+#include "Core/StateArchive.h"
+#include <mutex>
+#include <algorithm>
+#include <climits>
 
 namespace D {
 
+// ODE library init is process wide, engines share it
+
+static std::mutex _odeInitMux;
+static int _odeInitCounter = 0;
+
+static void odeAddRef()
+{
+	std::lock_guard<std::mutex> lock(_odeInitMux);
+	if (_odeInitCounter++ == 0)
+	{
+		int rc = ODE_CALL(dInitODE2)(0);
+		GUARD_FATAL(rc != 0);
+
+		log_printf(L"ODE BUILD FLAGS: %S", ODE_CALL(dGetConfiguration)());
+	}
+}
+
+static void odeRelease()
+{
+	std::lock_guard<std::mutex> lock(_odeInitMux);
+	if (--_odeInitCounter == 0)
+	{
+		ODE_CALL(dCloseODE)();
+	}
+}
+
+//=============================================================================
+
+// built-in multi-threaded implementation served by its own thread pool
+struct ThreadingODE : public NonCopyable
+{
+	ThreadingODE(int _numThreads, bool _isShared) : numThreads(_numThreads), isShared(_isShared)
+	{
+		impl = ODE_CALL(dThreadingAllocateMultiThreadedImplementation)();
+		GUARD_FATAL(impl);
+
+		pool = ODE_CALL(dThreadingAllocateThreadPool)((unsigned)numThreads, 0, dAllocateFlagBasicData | dAllocateFlagCollisionData, nullptr);
+		GUARD_FATAL(pool);
+
+		ODE_CALL(dThreadingThreadPoolServeMultiThreadedImplementation)(pool, impl);
+		log_printf(L"ThreadingODE: numThreads=%d isShared=%d", numThreads, (int)isShared);
+	}
+
+	~ThreadingODE()
+	{
+		ODE_CALL(dThreadingImplementationShutdownProcessing)(impl);
+		ODE_CALL(dThreadingThreadPoolWaitIdleState)(pool);
+		ODE_CALL(dThreadingFreeThreadPool)(pool);
+		ODE_CALL(dThreadingFreeImplementation)(impl);
+	}
+
+	dThreadingImplementationID impl = nullptr;
+	dThreadingThreadPoolID pool = nullptr;
+	std::mutex stepMux; // built-in implementation must not step several worlds at once
+	int numThreads = 0;
+	bool isShared = false;
+};
+
+static std::weak_ptr<ThreadingODE> _sharedThreading;
+
+static std::shared_ptr<ThreadingODE> acquireThreading(int numThreads, bool shared)
+{
+	if (!shared)
+		return std::make_shared<ThreadingODE>(numThreads, false);
+
+	// first engine decides pool size
+	std::lock_guard<std::mutex> lock(_odeInitMux);
+	auto threading = _sharedThreading.lock();
+	if (!threading)
+	{
+		threading = std::make_shared<ThreadingODE>(numThreads, true);
+		_sharedThreading = threading;
+	}
+	return threading;
+}
+
+//=============================================================================
+
 PhysicsEngineODE::PhysicsEngineODE()
 {
 	TRACE_CTOR(PhysicsEngineODE);
 
-	int rc = ODE_CALL(dInitODE2)(0);
-	GUARD_FATAL(rc != 0);
-
-	ODE_CALL(dAllocateODEDataForThread)(0xFFFFFFFF);
-	log_printf(L"ODE BUILD FLAGS: %S", ODE_CALL(dGetConfiguration)());
+	odeAddRef();
+	initThread();
 
 	world = ODE_CALL(dWorldCreate)();
 	GUARD_FATAL(world);
@@ -28,13 +107,18 @@ PhysicsEngineODE::PhysicsEngineODE()
 	ODE_CALL(dWorldSetDamping)(world, 0.0f, 0.0f);
 	ODE_CALL(dWorldSetQuickStepNumIterations)(world, 48);
 
+	// ODE ignores the size hint, contact records are reserved by setSolverConfig
 	contactGroup = ODE_CALL(dJointGroupCreate)(0);
 	GUARD_FATAL(contactGroup);
 
 	contactGroupDynamic = ODE_CALL(dJointGroupCreate)(0);
 	GUARD_FATAL(contactGroupDynamic);
 
+	contactRecords.reserve(solverConfig.contactPoolSize);
+	contactRecordsDynamic.reserve(solverConfig.contactPoolSize);
+
 	currentContactGroup = contactGroup;
+	currentContactRecords = &contactRecords;
 
 	spaceStatic = ODE_CALL(dSimpleSpaceCreate)(nullptr);
 	GUARD_FATAL(spaceStatic);
@@ -70,7 +154,8 @@ PhysicsEngineODE::~PhysicsEngineODE()
 	ODE_CALL(dJointGroupDestroy)(contactGroup);
 
 	ODE_CALL(dWorldDestroy)(world);
-	ODE_CALL(dCloseODE)();
+	threading.reset();
+	odeRelease();
 }
 
 dxSpace* PhysicsEngineODE::getStaticSubSpace(unsigned int index)
@@ -79,7 +164,7 @@ dxSpace* PhysicsEngineODE::getStaticSubSpace(unsigned int index)
 	if (iter != staticSubSpaces.end())
 		return iter->second;
 
-	auto space = ODE_CALL(dSimpleSpaceCreate)(spaceStatic);
+	auto space = createSpace(spaceConfig.staticType, spaceStatic, worldMin, worldMax);
 	GUARD_FATAL(space);
 
 	staticSubSpaces.insert({index, space});
@@ -99,6 +184,94 @@ dxSpace* PhysicsEngineODE::getDynamicSubSpace(unsigned int index)
 	return space;
 }
 
+dxSpace* PhysicsEngineODE::createSpace(CollisionSpaceType type, dxSpace* parent, const vec3f& bmin, const vec3f& bmax)
+{
+	switch (type)
+	{
+		case CollisionSpaceType::Hash:
+		{
+			auto space = ODE_CALL(dHashSpaceCreate)(parent);
+			ODE_CALL(dHashSpaceSetLevels)(space, spaceConfig.hashMinLevel, spaceConfig.hashMaxLevel);
+			return space;
+		}
+
+		case CollisionSpaceType::QuadTree:
+		{
+			// ODE quadtree splits along X and Z, Y is up like here
+			if (hasWorldBounds && bmax.x > bmin.x && bmax.z > bmin.z)
+			{
+				const dVector3 center = { (bmin.x + bmax.x) * 0.5f, (bmin.y + bmax.y) * 0.5f, (bmin.z + bmax.z) * 0.5f, 0 };
+				const dVector3 extents = { (bmax.x - bmin.x) * 0.5f, (bmax.y - bmin.y) * 0.5f, (bmax.z - bmin.z) * 0.5f, 0 };
+				return ODE_CALL(dQuadTreeSpaceCreate)(parent, center, extents, spaceConfig.quadTreeDepth);
+			}
+			// not sized yet, rebuilt by setWorldBounds
+			return ODE_CALL(dSimpleSpaceCreate)(parent);
+		}
+
+		case CollisionSpaceType::SweepAndPrune:
+			return ODE_CALL(dSweepAndPruneSpaceCreate)(parent, dSAP_AXES_XZY);
+
+		default:
+			return ODE_CALL(dSimpleSpaceCreate)(parent);
+	}
+}
+
+dxSpace* PhysicsEngineODE::replaceSpace(dxSpace* space, CollisionSpaceType type, const vec3f& bmin, const vec3f& bmax)
+{
+	auto newSpace = createSpace(type, nullptr, bmin, bmax);
+	GUARD_FATAL(newSpace);
+
+	while (ODE_CALL(dSpaceGetNumGeoms)(space) > 0)
+	{
+		auto geom = ODE_CALL(dSpaceGetGeom)(space, 0);
+		ODE_CALL(dSpaceRemove)(space, geom);
+		ODE_CALL(dSpaceAdd)(newSpace, geom);
+	}
+
+	auto parent = ODE_CALL(dGeomGetSpace)((dGeomID)space);
+	if (parent)
+	{
+		ODE_CALL(dSpaceRemove)(parent, (dGeomID)space);
+		ODE_CALL(dSpaceAdd)(parent, (dGeomID)newSpace);
+	}
+
+	ODE_CALL(dSpaceDestroy)(space);
+	return newSpace;
+}
+
+void PhysicsEngineODE::rebuildSpaces()
+{
+	// sector spaces first, they are moved to the new parent below
+	for (auto& pair : staticSubSpaces)
+	{
+		dReal aabb[6];
+		ODE_CALL(dGeomGetAABB)((dGeomID)pair.second, aabb);
+		pair.second = replaceSpace(pair.second, spaceConfig.staticType, vec3f(aabb[0], aabb[2], aabb[4]), vec3f(aabb[1], aabb[3], aabb[5]));
+	}
+
+	spaceStatic = replaceSpace(spaceStatic, spaceConfig.staticType, worldMin, worldMax);
+	spaceDynamic = replaceSpace(spaceDynamic, spaceConfig.dynamicType, worldMin, worldMax);
+}
+
+void PhysicsEngineODE::setCollisionSpaces(const CollisionSpaceConfig& config)
+{
+	log_printf(L"PhysicsEngineODE: setCollisionSpaces: static=%d dynamic=%d hashLevels=%d..%d quadTreeDepth=%d carSweepAndPrune=%d",
+		(int)config.staticType, (int)config.dynamicType, config.hashMinLevel, config.hashMaxLevel, config.quadTreeDepth, config.carSweepAndPrune);
+
+	spaceConfig = config;
+	rebuildSpaces();
+}
+
+void PhysicsEngineODE::setWorldBounds(const vec3f& bmin, const vec3f& bmax)
+{
+	worldMin = bmin;
+	worldMax = bmax;
+	hasWorldBounds = true;
+
+	if (spaceConfig.staticType == CollisionSpaceType::QuadTree || spaceConfig.dynamicType == CollisionSpaceType::QuadTree)
+		rebuildSpaces();
+}
+
 IRigidBodyPtr PhysicsEngineODE::createRigidBody()
 {
 	return std::make_shared<RigidBodyODE>(shared_from_this());
@@ -180,6 +353,7 @@ RayCastHit PhysicsEngineODE::rayCastImpl(const vec3f& pos, const vec3f& dir, dxG
 		hit.pos = vec3f(cg.pos);
 		hit.normal = vec3f(cg.normal);
 		hit.collisionObject = (ICollisionObject*)ODE_CALL(dGeomGetData)(cg.g2);
+		hit.triangle = (uint32_t)cg.side2;
 		hit.hasContact = true;
 	}
 
@@ -199,7 +373,7 @@ static void rayNearCallback(void* data, dxGeom* o1, dxGeom* o2)
 		const int maxContacts = 32;
 		dContactGeom contacts[maxContacts];
 
-		const int n = ODE_CALL(dCollide)(o1, o2, 1i64, &contacts[0], sizeof(dContactGeom));
+		const int n = ODE_CALL(dCollide)(o1, o2, 1, &contacts[0], sizeof(dContactGeom));
 
 		for (int i = 0; i < n; ++i)
 		{
@@ -213,14 +387,75 @@ static void rayNearCallback(void* data, dxGeom* o1, dxGeom* o2)
 	}
 }
 
+void PhysicsEngineODE::initThread()
+{
+	// ODE keeps collider caches in TLS, every thread that steps the world needs its own copy
+	ODE_CALL(dAllocateODEDataForThread)(0xFFFFFFFF);
+}
+
+void PhysicsEngineODE::setDeterministic(bool value)
+{
+	// dWorldStep solves islands in world list order without randomized constraint reordering,
+	// solver options that rely on shared ODE state must stay disabled while this is set
+	deterministic = value;
+	updateThreading();
+}
+
+void PhysicsEngineODE::setSolverConfig(const PhysicsSolverConfig& config)
+{
+	log_printf(L"PhysicsEngineODE: setSolverConfig: quickStep=%d iterations=%d numThreads=%d sharedThreadPool=%d maxPairContacts=%d",
+		config.quickStep, config.quickStepIterations, config.numThreads, config.sharedThreadPool, config.maxPairContacts);
+
+	solverConfig = config;
+	solverConfig.contactPoolSize = tclamp(config.contactPoolSize, 0, 65536);
+	contactRecords.reserve(solverConfig.contactPoolSize);
+	contactRecordsDynamic.reserve(solverConfig.contactPoolSize);
+	ODE_CALL(dWorldSetQuickStepNumIterations)(world, config.quickStepIterations);
+	updateThreading();
+}
+
+void PhysicsEngineODE::updateThreading()
+{
+	// threaded island stepping is not verified to be bit-exact, deterministic runs solve on calling thread
+	const int numThreads = deterministic ? 0 : solverConfig.numThreads;
+	const bool shared = solverConfig.sharedThreadPool != 0;
+
+	if (numThreads > 0 && threading && threading->isShared == shared && (shared || threading->numThreads == numThreads))
+		return;
+
+	ODE_CALL(dWorldSetStepThreadingImplementation)(world, nullptr, nullptr);
+	threading.reset();
+
+	if (numThreads > 0)
+	{
+		threading = acquireThreading(numThreads, shared);
+		ODE_CALL(dWorldSetStepThreadingImplementation)(world, ODE_CALL(dThreadingImplementationGetFunctions)(threading->impl), threading->impl);
+		ODE_CALL(dWorldSetStepIslandsProcessingMaxThreadCount)(world, (unsigned)numThreads);
+	}
+}
+
 void PhysicsEngineODE::step(float dt)
 {
 	if (noCollisionCounter)
+	{
 		noCollisionCounter--;
+	}
 	else
+	{
 		collisionStep(dt);
+		if (collisionCallback)
+			collisionCallback->onCollisionStepCompleted();
+	}
+
+	std::unique_lock<std::mutex> lock;
+	if (threading && threading->isShared)
+		lock = std::unique_lock<std::mutex>(threading->stepMux);
 
-	ODE_CALL(dWorldStep)(world, dt);
+	// QuickStep randomly reorders constraints using ODE global seed
+	if (solverConfig.quickStep && !deterministic)
+		ODE_CALL(dWorldQuickStep)(world, dt);
+	else
+		ODE_CALL(dWorldStep)(world, dt);
 }
 
 static void collisionNearCallback(void* data, dxGeom* o1, dxGeom* o2);
@@ -230,14 +465,21 @@ void PhysicsEngineODE::collisionStep(float dt)
 	if (currentFrame & 1)
 	{
 		ODE_CALL(dJointGroupEmpty)(contactGroupDynamic);
+		contactRecordsDynamic.clear();
 		currentContactGroup = contactGroupDynamic;
+		currentContactRecords = &contactRecordsDynamic;
 		ODE_CALL(dSpaceCollide2)((dGeomID)spaceDynamic, (dGeomID)spaceStatic, this, collisionNearCallback);
 	}
 	else
 	{
 		ODE_CALL(dJointGroupEmpty)(contactGroup);
+		contactRecords.clear();
 		currentContactGroup = contactGroup;
-		ODE_CALL(dSpaceCollide)(spaceDynamic, this, collisionNearCallback);
+		currentContactRecords = &contactRecords;
+		if (spaceConfig.carSweepAndPrune)
+			collideDynamicProxies();
+		else
+			ODE_CALL(dSpaceCollide)(spaceDynamic, this, collisionNearCallback);
 	}
 
 	currentFrame++;
@@ -281,6 +523,246 @@ static void collisionNearCallback(void* data, dxGeom* o1, dxGeom* o2)
 	}
 }
 
+void PhysicsEngineODE::addDynamicProxy(CollisionMeshODE* mesh)
+{
+	dynamicProxies.push_back(mesh);
+	sapOrder.clear();
+}
+
+void PhysicsEngineODE::removeDynamicProxy(CollisionMeshODE* mesh)
+{
+	eraseRemove(dynamicProxies, mesh);
+	sapOrder.clear();
+}
+
+void PhysicsEngineODE::collideDynamicProxies()
+{
+	const uint32_t numProxies = (uint32_t)dynamicProxies.size();
+	if (sapOrder.size() != numProxies)
+	{
+		sapOrder.resize(numProxies);
+		for (uint32_t i = 0; i < numProxies; ++i)
+			sapOrder[i] = i;
+	}
+
+	sapBounds.resize(numProxies * 6);
+	vec3f sum, sqsum;
+
+	for (uint32_t i = 0; i < numProxies; ++i)
+	{
+		dReal aabb[6];
+		ODE_CALL(dGeomGetAABB)(dynamicProxies[i]->proxy, aabb);
+
+		float* b = &sapBounds[i * 6];
+		b[0] = aabb[0]; b[1] = aabb[2]; b[2] = aabb[4];
+		b[3] = aabb[1]; b[4] = aabb[3]; b[5] = aabb[5];
+
+		const vec3f c((b[0] + b[3]) * 0.5f, 0.0f, (b[2] + b[5]) * 0.5f);
+		sum += c;
+		sqsum += vec3f(c.x * c.x, 0.0f, c.z * c.z);
+	}
+
+	// sweep along horizontal axis with the largest spread, usually close to track direction
+	if (numProxies > 1)
+	{
+		const float invN = 1.0f / numProxies;
+		const float varX = sqsum.x * invN - (sum.x * invN) * (sum.x * invN);
+		const float varZ = sqsum.z * invN - (sum.z * invN) * (sum.z * invN);
+		sapAxis = (varZ > varX) ? 2 : 0;
+	}
+
+	// insertion sort, order is nearly unchanged between frames, index breaks ties so result does not depend on history
+	const int axis = sapAxis;
+	auto less = [this, axis](uint32_t a, uint32_t b)
+	{
+		const float ka = sapBounds[a * 6 + axis], kb = sapBounds[b * 6 + axis];
+		return (ka < kb) || (ka == kb && a < b);
+	};
+
+	for (uint32_t i = 1; i < numProxies; ++i)
+	{
+		const uint32_t item = sapOrder[i];
+		uint32_t j = i;
+		for (; j > 0 && less(item, sapOrder[j - 1]); --j)
+			sapOrder[j] = sapOrder[j - 1];
+		sapOrder[j] = item;
+	}
+
+	sapPairs.clear();
+
+	for (uint32_t i = 0; i < numProxies; ++i)
+	{
+		const uint32_t a = sapOrder[i];
+		const float* ba = &sapBounds[a * 6];
+
+		for (uint32_t j = i + 1; j < numProxies; ++j)
+		{
+			const uint32_t b = sapOrder[j];
+			const float* bb = &sapBounds[b * 6];
+
+			if (bb[axis] > ba[axis + 3])
+				break;
+
+			if (bb[0] > ba[3] || bb[3] < ba[0] || bb[1] > ba[4] || bb[4] < ba[1] || bb[2] > ba[5] || bb[5] < ba[2])
+				continue;
+
+			sapPairs.push_back({a, b});
+		}
+	}
+
+	const int maxContacts = 32;
+	dContactGeom contacts[maxContacts];
+
+	for (const auto& pair : sapPairs)
+	{
+		auto* m1 = dynamicProxies[pair.first];
+		auto* m2 = dynamicProxies[pair.second];
+
+		auto b1 = ODE_CALL(dGeomGetBody)(m1->geom);
+		auto b2 = ODE_CALL(dGeomGetBody)(m2->geom);
+		if (b1 == b2)
+			continue;
+
+		const bool bMatch = (ODE_CALL(dGeomGetCategoryBits)(m1->geom) & ODE_CALL(dGeomGetCollideBits)(m2->geom))
+			&& (ODE_CALL(dGeomGetCategoryBits)(m2->geom) & ODE_CALL(dGeomGetCollideBits)(m1->geom));
+		if (!bMatch)
+			continue;
+
+		// oriented proxy boxes only select pairs, contacts always come from the meshes
+		if (ODE_CALL(dCollide)(m1->proxy, m2->proxy, 1, &contacts[0], sizeof(dContactGeom)) <= 0)
+			continue;
+
+		const int n = ODE_CALL(dCollide)(m1->geom, m2->geom, 4, &contacts[0], sizeof(dContactGeom));
+		if (n > 0)
+			onCollision(&contacts[0], n, m1->geom, m2->geom);
+	}
+}
+
+static inline float contactDist2(const dContactGeom& a, const dContactGeom& b)
+{
+	const float dx = a.pos[0] - b.pos[0], dy = a.pos[1] - b.pos[1], dz = a.pos[2] - b.pos[2];
+	return dx * dx + dy * dy + dz * dz;
+}
+
+static inline float contactArea2(const dContactGeom& a, const dContactGeom& b, const dContactGeom& c)
+{
+	const vec3f e1(b.pos[0] - a.pos[0], b.pos[1] - a.pos[1], b.pos[2] - a.pos[2]);
+	const vec3f e2(c.pos[0] - a.pos[0], c.pos[1] - a.pos[1], c.pos[2] - a.pos[2]);
+	const vec3f n = e1.cross(e2);
+	return n * n;
+}
+
+// Keeps up to maxContacts per normal cluster: deepest, farthest from it, largest triangle, largest quad, then by depth.
+// Surviving contacts keep their original order.
+static int reduceContacts(dContactGeom* contacts, int numContacts, int maxContacts, float normalCos)
+{
+	const int MaxInput = 64;
+	if (numContacts <= maxContacts || numContacts > MaxInput)
+		return numContacts;
+
+	int cluster[MaxInput];
+	int clusterRep[MaxInput];
+	bool keep[MaxInput];
+	int numClusters = 0;
+
+	for (int i = 0; i < numContacts; ++i)
+	{
+		const auto& n = contacts[i].normal;
+		int c = 0;
+		for (; c < numClusters; ++c)
+		{
+			const auto& rn = contacts[clusterRep[c]].normal;
+			if (n[0] * rn[0] + n[1] * rn[1] + n[2] * rn[2] >= normalCos)
+				break;
+		}
+		if (c == numClusters)
+			clusterRep[numClusters++] = i;
+		cluster[i] = c;
+		keep[i] = false;
+	}
+
+	int members[MaxInput];
+	for (int c = 0; c < numClusters; ++c)
+	{
+		int count = 0;
+		for (int i = 0; i < numContacts; ++i)
+		{
+			if (cluster[i] == c)
+				members[count++] = i;
+		}
+
+		if (count <= maxContacts)
+		{
+			for (int k = 0; k < count; ++k)
+				keep[members[k]] = true;
+			continue;
+		}
+
+		int picked[4] = {-1, -1, -1, -1};
+		int numPicked = 0;
+
+		for (int k = 0; k < count && numPicked < maxContacts && numPicked < 4; ++k)
+		{
+			int best = -1;
+			float bestScore = -1.0f;
+
+			for (int m = 0; m < count; ++m)
+			{
+				const int i = members[m];
+				if (keep[i])
+					continue;
+
+				const auto& p = contacts[i];
+				float score;
+				if (numPicked == 0)
+					score = p.depth;
+				else if (numPicked == 1)
+					score = contactDist2(p, contacts[picked[0]]);
+				else if (numPicked == 2)
+					score = contactArea2(contacts[picked[0]], contacts[picked[1]], p);
+				else
+					score = contactArea2(p, contacts[picked[0]], contacts[picked[1]])
+						+ contactArea2(p, contacts[picked[1]], contacts[picked[2]])
+						+ contactArea2(p, contacts[picked[2]], contacts[picked[0]]);
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = i;
+				}
+			}
+
+			if (best < 0)
+				break;
+
+			keep[best] = true;
+			picked[numPicked++] = best;
+		}
+
+		for (int k = numPicked; k < maxContacts; ++k)
+		{
+			int best = -1;
+			for (int m = 0; m < count; ++m)
+			{
+				const int i = members[m];
+				if (!keep[i] && (best < 0 || contacts[i].depth > contacts[best].depth))
+					best = i;
+			}
+			if (best < 0)
+				break;
+			keep[best] = true;
+		}
+	}
+
+	int n = 0;
+	for (int i = 0; i < numContacts; ++i)
+	{
+		if (keep[i])
+			contacts[n++] = contacts[i];
+	}
+	return n;
+}
+
 void PhysicsEngineODE::onCollision(dContactGeom* contacts, int numContacts, dxGeom* o1, dxGeom* o2)
 {
 	dBodyID body0 = ODE_CALL(dGeomGetBody)(o1);
@@ -292,6 +774,29 @@ void PhysicsEngineODE::onCollision(dContactGeom* contacts, int numContacts, dxGe
 	auto* userData0 = body0 ? (IRigidBody*)ODE_CALL(dBodyGetData)(body0) : nullptr;
 	auto* userData1 = body1 ? (IRigidBody*)ODE_CALL(dBodyGetData)(body1) : nullptr;
 
+	const bool isBoxVsMesh = (geomClass0 == dBoxClass && geomClass1 == dTriMeshClass)
+		|| (geomClass0 == dTriMeshClass && geomClass1 == dBoxClass);
+
+	if (isBoxVsMesh && (body0 || body1))
+	{
+		int n = 0;
+		for (int i = 0; i < numContacts; ++i)
+		{
+			const dContactGeom& cg = contacts[i];
+
+			dVector3 loc_normal;
+			ODE_CALL(dBodyVectorFromWorld)((body0 ? body0 : body1), 
+				cg.normal[0], cg.normal[1], cg.normal[2], loc_normal);
+
+			if (loc_normal[1] >= 0.9f)
+				contacts[n++] = cg;
+		}
+		numContacts = n;
+	}
+
+	if (solverConfig.maxPairContacts > 0)
+		numContacts = reduceContacts(contacts, numContacts, solverConfig.maxPairContacts, solverConfig.contactNormalCos);
+
 	for (int i = 0; i < numContacts; ++i)
 	{
 		const dContactGeom& cg = contacts[i];
@@ -300,8 +805,7 @@ void PhysicsEngineODE::onCollision(dContactGeom* contacts, int numContacts, dxGe
 		memzero(cj);
 		cj.geom = cg;
 
-		if ((geomClass0 != dBoxClass || geomClass1 != dTriMeshClass) 
-			&& (geomClass0 != dTriMeshClass || geomClass1 != dBoxClass))
+		if (!isBoxVsMesh)
 		{
 			cj.surface.mode = 28692; // dContactBounce | dContactSoftCFM | dContactApprox1
 			cj.surface.mu = 0.25f;
@@ -310,16 +814,6 @@ void PhysicsEngineODE::onCollision(dContactGeom* contacts, int numContacts, dxGe
 		}
 		else
 		{
-			if (body0 || body1)
-			{
-				dVector3 loc_normal;
-				ODE_CALL(dBodyVectorFromWorld)((body0 ? body0 : body1), 
-					cg.normal[0], cg.normal[1], cg.normal[2], loc_normal);
-
-				if (loc_normal[1] < 0.9f)
-					continue;
-			}
-
 			cj.surface.mode = 28700; // dContactBounce | dContactSoftERP | dContactSoftCFM | dContactApprox1
 			cj.surface.mu = 0.1f;
 			cj.surface.bounce = 0;
@@ -329,6 +823,7 @@ void PhysicsEngineODE::onCollision(dContactGeom* contacts, int numContacts, dxGe
 
 		dJointID j = ODE_CALL(dJointCreateContact)(world, currentContactGroup, &cj);
 		ODE_CALL(dJointAttach)(j, body0, body1);
+		currentContactRecords->push_back({cj, body0, body1});
 
 		if (collisionCallback)
 		{
@@ -340,4 +835,104 @@ void PhysicsEngineODE::onCollision(dContactGeom* contacts, int numContacts, dxGe
 	}
 }
 
+//=============================================================================
+
+void PhysicsEngineODE::serializeState(StateArchive& ar)
+{
+	ar.marker(0x45444F50); // PODE
+
+	ar.io(currentFrame);
+	ar.io(noCollisionCounter);
+
+	uint32_t numBodies = (uint32_t)bodies.size();
+	ar.io(numBodies);
+	GUARD_FATAL(numBodies == (uint32_t)bodies.size());
+
+	for (auto* body : bodies)
+		body->serializeState(ar);
+
+	// ODE prepends new joints to the world list, recreate contacts in their original order:
+	// the group filled by the last collisionStep is the newest one
+	const bool dynamicIsNewest = ((currentFrame - 1) & 1) != 0;
+	if (dynamicIsNewest)
+	{
+		serializeContacts(ar, contactGroup, contactRecords);
+		serializeContacts(ar, contactGroupDynamic, contactRecordsDynamic);
+	}
+	else
+	{
+		serializeContacts(ar, contactGroupDynamic, contactRecordsDynamic);
+		serializeContacts(ar, contactGroup, contactRecords);
+	}
+}
+
+void PhysicsEngineODE::serializeContacts(StateArchive& ar, dxJointGroup* group, std::vector<ContactRecordODE>& records)
+{
+	// runs every step when hashing state, sorted scratch vector avoids per-step allocations
+	if (ar.isSaving() && !records.empty())
+	{
+		bodyIndexScratch.clear();
+		for (size_t i = 0; i < bodies.size(); ++i)
+			bodyIndexScratch.push_back({bodies[i]->id, (int32_t)i});
+		std::sort(bodyIndexScratch.begin(), bodyIndexScratch.end());
+	}
+
+	auto findBodyIndex = [this](dxBody* body)
+	{
+		auto iter = std::lower_bound(bodyIndexScratch.begin(), bodyIndexScratch.end(), std::make_pair(body, (int32_t)INT32_MIN));
+		GUARD_FATAL(iter != bodyIndexScratch.end() && iter->first == body);
+		return iter->second;
+	};
+
+	uint32_t numContacts = (uint32_t)records.size();
+	ar.io(numContacts);
+
+	if (ar.isLoading())
+	{
+		ODE_CALL(dJointGroupEmpty)(group);
+		records.resize(numContacts);
+	}
+
+	for (auto& rec : records)
+	{
+		// copy by fields: padding and unused vector components stay zero (buffers are hashed),
+		// geoms are not used by the solver and are not valid across simulators
+		dContact contact;
+		memzero(contact);
+		contact.surface = rec.contact.surface;
+		memcpy(contact.geom.pos, rec.contact.geom.pos, sizeof(dReal) * 3);
+		memcpy(contact.geom.normal, rec.contact.geom.normal, sizeof(dReal) * 3);
+		contact.geom.depth = rec.contact.geom.depth;
+		contact.geom.side1 = rec.contact.geom.side1;
+		contact.geom.side2 = rec.contact.geom.side2;
+		memcpy(contact.fdir1, rec.contact.fdir1, sizeof(dReal) * 3);
+
+		int32_t index0 = -1, index1 = -1;
+		if (ar.isSaving())
+		{
+			// contacts with static geoms have no body, any other body must be registered
+			if (rec.body0)
+				index0 = findBodyIndex(rec.body0);
+			if (rec.body1)
+				index1 = findBodyIndex(rec.body1);
+		}
+
+		ar.io(contact);
+		ar.io(index0);
+		ar.io(index1);
+
+		if (ar.isLoading())
+		{
+			GUARD_FATAL(index0 >= -1 && index0 < (int32_t)bodies.size() && index1 >= -1 && index1 < (int32_t)bodies.size());
+
+			rec.contact = contact;
+			rec.body0 = (index0 >= 0 ? bodies[index0]->id : nullptr);
+			rec.body1 = (index1 >= 0 ? bodies[index1]->id : nullptr);
+
+			dJointID j = ODE_CALL(dJointCreateContact)(world, group, &rec.contact);
+			ODE_CALL(dJointAttach)(j, rec.body0, rec.body1);
+		}
+	}
+}
+
 }
@@ -14,6 +14,18 @@
 
 namespace D {
 
+struct RigidBodyODE;
+struct ThreadingODE;
+struct CollisionMeshODE;
+
+// contact joint parameters kept for snapshots, ODE doesn't expose them after creation
+struct ContactRecordODE
+{
+	dContact contact;
+	dxBody* body0;
+	dxBody* body1;
+};
+
 struct PhysicsEngineODE : public IPhysicsEngine, std::enable_shared_from_this<PhysicsEngineODE>
 {
 	PhysicsEngineODE();
@@ -33,19 +45,33 @@ struct PhysicsEngineODE : public IPhysicsEngine, std::enable_shared_from_this<Ph
 	IRayCasterPtr createRayCaster(float length) override;
 
 	void setCollisionCallback(ICollisionCallback* callback) override;
+	void setCollisionSpaces(const CollisionSpaceConfig& config) override;
+	void setWorldBounds(const vec3f& bmin, const vec3f& bmax) override;
 	RayCastHit rayCast(const vec3f& pos, const vec3f& dir, float length) override;
 	RayCastHit rayCast(const vec3f& pos, const vec3f& dir, IRayCasterPtr ray) override;
 
+	void initThread() override;
+	void setDeterministic(bool value) override;
+	void setSolverConfig(const PhysicsSolverConfig& config) override;
 	void step(float dt) override;
+	void serializeState(StateArchive& ar) override;
 
 	// Internals
 
 	dxSpace* getStaticSubSpace(unsigned int index);
 	dxSpace* getDynamicSubSpace(unsigned int index);
+	dxSpace* createSpace(CollisionSpaceType type, dxSpace* parent, const vec3f& bmin, const vec3f& bmax);
+	dxSpace* replaceSpace(dxSpace* space, CollisionSpaceType type, const vec3f& bmin, const vec3f& bmax);
+	void rebuildSpaces();
+	void updateThreading();
+	void addDynamicProxy(CollisionMeshODE* mesh);
+	void removeDynamicProxy(CollisionMeshODE* mesh);
+	void collideDynamicProxies();
 	RayCastHit rayCastImpl(const vec3f& pos, const vec3f& dir, dxGeom* dxray);
 
 	void collisionStep(float dt);
 	void onCollision(dContactGeom* contacts, int numContacts, dxGeom* o1, dxGeom* o2);
+	void serializeContacts(StateArchive& ar, dxJointGroup* group, std::vector<ContactRecordODE>& records);
 
 	dxWorld* world = nullptr;
 	dxSpace* spaceStatic = nullptr;
@@ -53,12 +79,29 @@ struct PhysicsEngineODE : public IPhysicsEngine, std::enable_shared_from_this<Ph
 	dxJointGroup* contactGroup = nullptr;
 	dxJointGroup* contactGroupDynamic = nullptr;
 	dxJointGroup* currentContactGroup = nullptr;
+	std::vector<ContactRecordODE> contactRecords; // joints of contactGroup
+	std::vector<ContactRecordODE> contactRecordsDynamic; // joints of contactGroupDynamic
+	std::vector<ContactRecordODE>* currentContactRecords = nullptr;
+	std::vector<std::pair<dxBody*, int32_t>> bodyIndexScratch; // sorted by body, reused by serializeContacts
+	std::vector<RigidBodyODE*> bodies; // creation order
 	dxGeom* ray = nullptr;
 	ICollisionCallback* collisionCallback = nullptr;
 	std::map<unsigned int, dxSpace*> staticSubSpaces;
 	std::map<unsigned int, dxSpace*> dynamicSubSpaces;
+	CollisionSpaceConfig spaceConfig;
+	vec3f worldMin;
+	vec3f worldMax;
+	bool hasWorldBounds = false;
+	PhysicsSolverConfig solverConfig;
+	std::shared_ptr<ThreadingODE> threading;
+	std::vector<CollisionMeshODE*> dynamicProxies; // creation order
+	std::vector<uint32_t> sapOrder; // dynamicProxies sorted by min bound along sapAxis, kept between frames
+	std::vector<std::pair<uint32_t, uint32_t>> sapPairs; // overlapping proxies of last collisionStep
+	std::vector<float> sapBounds; // 6 per proxy: min xyz, max xyz
+	int sapAxis = 0;
 	unsigned int currentFrame = 0;
 	int noCollisionCounter = 0;
+	bool deterministic = false;
 };
 
 DECL_SHARED_PTR(PhysicsEngineODE);
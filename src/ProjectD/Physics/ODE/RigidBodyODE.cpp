@@ -1,4 +1,5 @@
 #include "Physics/ODE/RigidBodyODE.h"
+#include "Core/StateArchive.h"
 
 namespace D {
 
@@ -16,12 +17,16 @@ RigidBodyODE::RigidBodyODE(PhysicsEngineODEPtr pcore)
 	ODE_CALL(dBodySetFiniteRotationAxis)(id, 0, 0, 0);
 	ODE_CALL(dBodySetLinearDamping)(id, 0);
 	ODE_CALL(dBodySetAngularDamping)(id, 0);
+
+	core->bodies.push_back(this);
 }
 
 RigidBodyODE::~RigidBodyODE()
 {
 	//TRACE_DTOR(RigidBodyODE);
 
+	eraseRemove(core->bodies, this);
+
 	for (auto& g : geoms)
 		dGeomDestroy(g);
 	geoms.clear();
@@ -33,6 +38,18 @@ RigidBodyODE::~RigidBodyODE()
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
+void RigidBodyODE::setUserPointer(void* data)
+{
+	userPointer = data;
+}
+
+void* RigidBodyODE::getUserPointer()
+{
+	return userPointer;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
 void RigidBodyODE::setEnabled(bool value)
 {
 	if (value)
@@ -313,7 +330,76 @@ void RigidBodyODE::addMeshCollider(ITriMeshPtr trimesh, const mat44f& offset, un
 	//ODE_CALL(dGeomSetOffsetPosition)(pCollider->geom, 0, 0, 0); // TODO: check
 	ODE_CALL(dGeomSetOffsetPosition)(pCollider->geom, offset.M41, offset.M42, offset.M43);
 
+	// mesh space bounds, same offset as the mesh
+	const auto* vb = trimesh->getVB();
+	vec3f bmin(vb[0].x, vb[0].y, vb[0].z), bmax = bmin;
+	for (size_t i = 1; i < trimesh->getVertexCount(); ++i)
+	{
+		bmin = vec3f(tmin(bmin.x, vb[i].x), tmin(bmin.y, vb[i].y), tmin(bmin.z, vb[i].z));
+		bmax = vec3f(tmax(bmax.x, vb[i].x), tmax(bmax.y, vb[i].y), tmax(bmax.z, vb[i].z));
+	}
+	const vec3f centre = ((bmin + bmax) * 0.5f) * offset;
+	const vec3f size = bmax - bmin;
+
+	pCollider->proxy = ODE_CALL(dCreateBox)(nullptr, tmax(size.x, 0.01f), tmax(size.y, 0.01f), tmax(size.z, 0.01f));
+	GUARD_FATAL(pCollider->proxy);
+
+	ODE_CALL(dGeomSetBody)(pCollider->proxy, id);
+	ODE_CALL(dGeomSetOffsetRotation)(pCollider->proxy, r);
+	ODE_CALL(dGeomSetOffsetPosition)(pCollider->proxy, ODE_V3(centre));
+	ODE_CALL(dGeomSetData)(pCollider->proxy, ODE_CALL(dGeomGetData)(pCollider->geom));
+	ODE_CALL(dGeomSetCategoryBits)(pCollider->proxy, category);
+	ODE_CALL(dGeomSetCollideBits)(pCollider->proxy, collideMask);
+	core->addDynamicProxy(pCollider.get());
+
 	collisionMeshes.emplace_back(std::move(pCollider));
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RigidBodyODE::serializeState(StateArchive& ar)
+{
+	dReal pos[3], linearVel[3], angularVel[3], force[3], torque[3]; // 4th component of dVector3 is padding
+	dQuaternion quat;
+	dMass mass;
+	int enabled = 0;
+
+	if (ar.isSaving())
+	{
+		memcpy(pos, ODE_CALL(dBodyGetPosition)(id), sizeof(pos));
+		memcpy(quat, ODE_CALL(dBodyGetQuaternion)(id), sizeof(dQuaternion));
+		memcpy(linearVel, ODE_CALL(dBodyGetLinearVel)(id), sizeof(linearVel));
+		memcpy(angularVel, ODE_CALL(dBodyGetAngularVel)(id), sizeof(angularVel));
+		memcpy(force, ODE_CALL(dBodyGetForce)(id), sizeof(force));
+		memcpy(torque, ODE_CALL(dBodyGetTorque)(id), sizeof(torque));
+		ODE_CALL(dBodyGetMass)(id, &mass);
+		enabled = ODE_CALL(dBodyIsEnabled)(id);
+	}
+
+	ar.io(pos);
+	ar.io(quat);
+	ar.io(linearVel);
+	ar.io(angularVel);
+	ar.io(force);
+	ar.io(torque);
+	ar.io(mass);
+	ar.io(enabled);
+
+	if (ar.isLoading())
+	{
+		ODE_CALL(dBodySetMass)(id, &mass);
+		ODE_CALL(dBodySetPosition)(id, pos[0], pos[1], pos[2]);
+		ODE_CALL(dBodySetQuaternion)(id, quat);
+		ODE_CALL(dBodySetLinearVel)(id, linearVel[0], linearVel[1], linearVel[2]);
+		ODE_CALL(dBodySetAngularVel)(id, angularVel[0], angularVel[1], angularVel[2]);
+		ODE_CALL(dBodySetForce)(id, force[0], force[1], force[2]);
+		ODE_CALL(dBodySetTorque)(id, torque[0], torque[1], torque[2]);
+
+		if (enabled)
+			ODE_CALL(dBodyEnable)(id);
+		else
+			ODE_CALL(dBodyDisable)(id);
+	}
+}
+
 }
@@ -9,6 +9,9 @@ struct RigidBodyODE : public IRigidBody, PhysicsChildODE
 	RigidBodyODE(PhysicsEngineODEPtr core);
 	~RigidBodyODE();
 
+	void setUserPointer(void* data) override;
+	void* getUserPointer() override;
+
 	void setEnabled(bool value) override;
 	bool isEnabled() override;
 	void setAutoDisable(bool mode) override;
@@ -50,9 +53,12 @@ struct RigidBodyODE : public IRigidBody, PhysicsChildODE
 	void addBoxCollider(const vec3f& pos, const vec3f& size, unsigned int spaceId, unsigned int category, unsigned long collideMask) override;
 	void addMeshCollider(ITriMeshPtr trimesh, const mat44f& offset, unsigned int spaceId, unsigned long category, unsigned long collideMask) override;
 
+	void serializeState(StateArchive& ar);
+
 	dxBody* id = nullptr;
 	std::vector<dxGeom*> geoms;
 	std::vector<std::shared_ptr<CollisionMeshODE>> collisionMeshes;
+	void* userPointer = nullptr;
 };
 
 DECL_SHARED_PTR(RigidBodyODE);
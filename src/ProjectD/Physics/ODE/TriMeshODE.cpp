@@ -19,26 +19,46 @@ void TriMeshODE::resize(size_t vertexCount, size_t indexCount)
 
 	vertices.resize(vertexCount);
 	indices.resize(indexCount);
+
+	viewVB = nullptr;
+	viewIB = nullptr;
+	viewVertexCount = 0;
+	viewIndexCount = 0;
+}
+
+void TriMeshODE::setView(const TriMeshVertex* vb, size_t vertexCount, const TriMeshIndex* ib, size_t indexCount)
+{
+	GUARD_FATAL(vb && vertexCount > 0);
+	GUARD_FATAL(ib && indexCount > 0);
+
+	vertices.clear();
+	indices.clear();
+
+	// ODE only reads the buffers
+	viewVB = const_cast<TriMeshVertex*>(vb);
+	viewIB = const_cast<TriMeshIndex*>(ib);
+	viewVertexCount = vertexCount;
+	viewIndexCount = indexCount;
 }
 
 TriMeshVertex* TriMeshODE::getVB()
 {
-	return vertices.data();
+	return viewVB ? viewVB : vertices.data();
 }
 
 size_t TriMeshODE::getVertexCount()
 {
-	return vertices.size();
+	return viewVB ? viewVertexCount : vertices.size();
 }
 
 TriMeshIndex* TriMeshODE::getIB()
 {
-	return indices.data();
+	return viewIB ? viewIB : indices.data();
 }
 
 size_t TriMeshODE::getIndexCount()
 {
-	return indices.size();
+	return viewIB ? viewIndexCount : indices.size();
 }
 
 }
@@ -10,6 +10,7 @@ struct TriMeshODE : public ITriMesh
 	~TriMeshODE();
 
 	void resize(size_t vertexCount, size_t indexCount) override;
+	void setView(const TriMeshVertex* vb, size_t vertexCount, const TriMeshIndex* ib, size_t indexCount) override;
 	TriMeshVertex* getVB() override;
 	size_t getVertexCount() override;
 	TriMeshIndex* getIB() override;
@@ -17,6 +18,12 @@ struct TriMeshODE : public ITriMesh
 
 	std::vector<TriMeshVertex> vertices;
 	std::vector<TriMeshIndex> indices;
+
+	// setView
+	TriMeshVertex* viewVB = nullptr;
+	TriMeshIndex* viewIB = nullptr;
+	size_t viewVertexCount = 0;
+	size_t viewIndexCount = 0;
 };
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Sim/Surface.h"
+#include <vector>
 
 namespace D {
 
@@ -9,11 +10,22 @@ struct TrackRayCastHit : public RayCastHit
 	Surface* surface = nullptr;
 };
 
+// Track triangles around the last contact of a tyre, any ray whose segment stays inside the box is resolved against them only
+struct TrackContactCache
+{
+	vec3f bmin;
+	vec3f bmax;
+	std::vector<uint32_t> triangles;
+	bool valid = false;
+};
+
 struct ITrackRayCastProvider : public virtual IObject
 {
 	virtual IRayCasterPtr createRayCaster(float length) = 0;
 	virtual bool rayCast(const vec3f& pos, const vec3f& dir, float length, TrackRayCastHit& hit) = 0;
 	virtual bool rayCastWithRayCaster(const vec3f& pos, const vec3f& dir, IRayCasterPtr ray, TrackRayCastHit& hit) = 0;
+	virtual Surface* getHitSurface(const RayCastHit& hit) = 0;
+	virtual void rayCastBatch(const vec3f* pos, const vec3f* dir, size_t count, float length, TrackContactCache* const* caches, TrackRayCastHit* hits) = 0; // caches optional, one per ray when set
 };
 
 }
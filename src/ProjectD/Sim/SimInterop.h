@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <new>
+
+namespace D {
+
+// Shared memory channel between simulator and out-of-process controllers.
+// Lock-free single producer / single consumer ring of frames, header only so clients can include it as is.
+// Layout: SimInteropHeader | frame[0] | ... | frame[numFrames - 1], frame = SimInteropFrame | item[maxCars]
+
+#define SIM_INTEROP_STATE_NAME L"Local\\projectd_state"
+#define SIM_INTEROP_INPUT_NAME L"Local\\projectd_input"
+#define SIM_INTEROP_STATE_EVENT_NAME L"Local\\projectd_state_event"
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "SimInterop: 64-bit atomics must be lock-free to live in shared memory");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "SimInterop: signalWord is used as futex");
+
+struct SimInteropHeader
+{
+	static const uint32_t Magic = 0x49494450; // PDII
+	static const uint32_t Version = 4;
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t numFrames = 0;
+	uint32_t frameSize = 0; // including SimInteropFrame
+	uint32_t itemSize = 0; // sizeof(CarState) or sizeof(CarControls)
+	int32_t maxCars = 0;
+	uint32_t overwrite = 0; // producer recycles unread frames instead of dropping new ones
+
+	alignas(64) std::atomic<uint64_t> writeIndex; // frames published by producer
+	std::atomic<uint64_t> droppedFrames; // frames producer skipped because ring was full
+	alignas(64) std::atomic<uint64_t> readIndex; // frames released by consumer
+	std::atomic<uint32_t> numWaiters; // consumers blocked in SharedEvent::wait
+
+	alignas(64) std::atomic<uint32_t> signalWord; // bumped on every publish, futex word on Linux
+};
+
+struct SimInteropFrame
+{
+	std::atomic<uint32_t> sequence; // seqlock, odd while producer writes the frame
+	int32_t numCars = 0;
+	uint64_t stepId = 0; // producer step counter
+	double physicsTime = 0;
+};
+
+struct SimInteropRing
+{
+	inline static uint32_t computeFrameSize(uint32_t itemSize, int32_t maxCars)
+	{
+		const size_t size = sizeof(SimInteropFrame) + (size_t)itemSize * (size_t)maxCars;
+		return (uint32_t)((size + 63) & ~(size_t)63);
+	}
+
+	inline static size_t computeSize(uint32_t itemSize, int32_t maxCars, uint32_t numFrames)
+	{
+		return sizeof(SimInteropHeader) + (size_t)computeFrameSize(itemSize, maxCars) * numFrames;
+	}
+
+	// owner side, memory must be at least computeSize() bytes
+	inline void create(void* data, uint32_t itemSize, int32_t maxCars, uint32_t numFrames, bool overwrite)
+	{
+		header = new (data) SimInteropHeader();
+		header->numFrames = numFrames;
+		header->overwrite = overwrite ? 1 : 0;
+		header->frameSize = computeFrameSize(itemSize, maxCars);
+		header->itemSize = itemSize;
+		header->maxCars = maxCars;
+		header->writeIndex.store(0, std::memory_order_relaxed);
+		header->droppedFrames.store(0, std::memory_order_relaxed);
+		header->readIndex.store(0, std::memory_order_relaxed);
+		header->numWaiters.store(0, std::memory_order_relaxed);
+		header->signalWord.store(0, std::memory_order_relaxed);
+		frames = (uint8_t*)data + sizeof(SimInteropHeader);
+		for (uint32_t i = 0; i < numFrames; ++i)
+			getFrame(i)->sequence.store(0, std::memory_order_relaxed);
+		header->version = SimInteropHeader::Version;
+		std::atomic_thread_fence(std::memory_order_release);
+		header->magic = SimInteropHeader::Magic;
+	}
+
+	// client side, fails if owner did not create the ring yet or item size does not match
+	inline bool attach(void* data, uint32_t itemSize)
+	{
+		auto* h = (SimInteropHeader*)data;
+		if (h->magic != SimInteropHeader::Magic || h->version != SimInteropHeader::Version || h->itemSize != itemSize)
+			return false;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		header = h;
+		frames = (uint8_t*)data + sizeof(SimInteropHeader);
+		return true;
+	}
+
+	inline bool isValid() const { return header != nullptr; }
+
+	inline SimInteropFrame* getFrame(uint64_t index) const
+	{
+		return (SimInteropFrame*)(frames + (size_t)(index % header->numFrames) * header->frameSize);
+	}
+
+	inline void* getItems(const SimInteropFrame* frame) const
+	{
+		return (uint8_t*)frame + sizeof(SimInteropFrame);
+	}
+
+	//
+	// producer
+	//
+
+	// returns nullptr and counts the drop when consumer is numFrames behind,
+	// in overwrite mode the oldest unread frame is recycled instead and consumer detects it in endRead() by its sequence
+	inline SimInteropFrame* beginWrite()
+	{
+		const uint64_t w = header->writeIndex.load(std::memory_order_relaxed);
+		if (!header->overwrite)
+		{
+			const uint64_t r = header->readIndex.load(std::memory_order_acquire);
+			if (w - r >= header->numFrames)
+			{
+				header->droppedFrames.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			}
+		}
+		auto* frame = getFrame(w);
+		frame->sequence.store(frame->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release); // odd sequence is visible before any payload write
+		return frame;
+	}
+
+	inline void endWrite()
+	{
+		auto* frame = getFrame(header->writeIndex.load(std::memory_order_relaxed));
+		frame->sequence.store(frame->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		header->writeIndex.fetch_add(1, std::memory_order_release);
+	}
+
+	// call after endWrite, true if a consumer sleeps and the event has to be signaled
+	inline bool notify()
+	{
+		header->signalWord.fetch_add(1, std::memory_order_seq_cst);
+		return header->numWaiters.load(std::memory_order_seq_cst) != 0;
+	}
+
+	//
+	// consumer
+	//
+
+	// wait protocol: word = beginWait(); if (!getPendingFrames()) event.wait(word, timeout); endWait();
+	inline uint32_t beginWait()
+	{
+		header->numWaiters.fetch_add(1, std::memory_order_seq_cst);
+		return header->signalWord.load(std::memory_order_seq_cst);
+	}
+
+	inline void endWait()
+	{
+		header->numWaiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	inline uint64_t getPendingFrames() const
+	{
+		return header->writeIndex.load(std::memory_order_acquire) - header->readIndex.load(std::memory_order_relaxed);
+	}
+
+	// oldest unread frame or nullptr, skips frames the producer already recycled
+	inline const SimInteropFrame* beginRead(uint64_t& index)
+	{
+		const uint64_t w = header->writeIndex.load(std::memory_order_acquire);
+		uint64_t r = header->readIndex.load(std::memory_order_relaxed);
+		if (r == w)
+			return nullptr;
+		if (w - r > header->numFrames)
+			r = w - header->numFrames;
+		index = r;
+		return beginReadFrame(r);
+	}
+
+	// newest published frame or nullptr, everything older is treated as consumed
+	inline const SimInteropFrame* beginReadLatest(uint64_t& index)
+	{
+		const uint64_t w = header->writeIndex.load(std::memory_order_acquire);
+		if (header->readIndex.load(std::memory_order_relaxed) == w)
+			return nullptr;
+		index = w - 1;
+		return beginReadFrame(index);
+	}
+
+	// releases the slot, returns false if producer recycled it while it was being read (overwrite mode only)
+	inline bool endRead(uint64_t index)
+	{
+		std::atomic_thread_fence(std::memory_order_acquire); // payload reads complete before sequence is checked again
+		const uint32_t seq = getFrame(index)->sequence.load(std::memory_order_relaxed);
+		const uint64_t w = header->writeIndex.load(std::memory_order_relaxed);
+		header->readIndex.store(index + 1, std::memory_order_release);
+		return (!header->overwrite || (seq == readSequence && (seq & 1) == 0 && w < index + header->numFrames));
+	}
+
+	inline const SimInteropFrame* beginReadFrame(uint64_t index)
+	{
+		const auto* frame = getFrame(index);
+		readSequence = frame->sequence.load(std::memory_order_acquire);
+		return frame;
+	}
+
+	SimInteropHeader* header = nullptr;
+	uint8_t* frames = nullptr;
+	uint32_t readSequence = 0; // consumer, frame sequence seen by beginRead
+};
+
+}
@@ -0,0 +1,86 @@
+#include "Sim/SimInteropClient.h"
+#include "Car/CarState.h"
+#include "Car/CarControls.h"
+#include "Core/Diag.h"
+
+namespace D {
+
+SimInteropClient::SimInteropClient()
+{
+}
+
+SimInteropClient::~SimInteropClient()
+{
+	close();
+}
+
+static bool attachRing(SharedMemory& memory, SimInteropRing& ring, const wchar_t* name, uint32_t itemSize)
+{
+	// map header first to learn ring geometry
+	memory.open(name, sizeof(SimInteropHeader));
+	if (!memory.isValid())
+		return false;
+
+	auto* header = (SimInteropHeader*)memory.data();
+	if (header->magic != SimInteropHeader::Magic || header->version != SimInteropHeader::Version || header->itemSize != itemSize)
+	{
+		log_printf(L"ERROR: SimInteropClient: incompatible channel \"%s\"", name);
+		memory.close();
+		return false;
+	}
+
+	const size_t size = sizeof(SimInteropHeader) + (size_t)header->frameSize * header->numFrames;
+	memory.open(name, size);
+
+	return memory.isValid() && ring.attach(memory.data(), itemSize);
+}
+
+bool SimInteropClient::open()
+{
+	close();
+
+	if (!attachRing(stateMemory, stateRing, SIM_INTEROP_STATE_NAME, sizeof(CarState))
+		|| !attachRing(inputMemory, inputRing, SIM_INTEROP_INPUT_NAME, sizeof(CarControls)))
+	{
+		close();
+		return false;
+	}
+
+	stateEvent.open(SIM_INTEROP_STATE_EVENT_NAME, &stateRing.header->signalWord);
+	if (!stateEvent.isValid())
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void SimInteropClient::close()
+{
+	stateEvent.close();
+	stateRing = SimInteropRing();
+	inputRing = SimInteropRing();
+	stateMemory.close();
+	inputMemory.close();
+}
+
+uint64_t SimInteropClient::waitState(unsigned int timeoutMs)
+{
+	uint64_t pending = stateRing.getPendingFrames();
+	if (pending)
+		return pending;
+
+	const uint32_t word = stateRing.beginWait();
+	pending = stateRing.getPendingFrames();
+	if (!pending)
+	{
+		stateEvent.wait(word, timeoutMs);
+		pending = stateRing.getPendingFrames();
+	}
+	stateRing.endWait();
+
+	return pending;
+}
+
+}
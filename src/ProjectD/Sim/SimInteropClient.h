@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Sim/SimInterop.h"
+#include "Core/SharedMemory.h"
+#include "Core/SharedEvent.h"
+
+namespace D {
+
+// Out-of-process side of the interop channel: consumes CarState frames, produces CarControls frames.
+struct SimInteropClient
+{
+	SimInteropClient();
+	~SimInteropClient();
+
+	bool open(); // false if simulator is not running with [INTEROP] ENABLED=1
+	void close();
+
+	// sleeps until simulator publishes a state frame, returns number of unread frames, 0 on timeout
+	uint64_t waitState(unsigned int timeoutMs);
+
+	SharedMemory stateMemory;
+	SharedMemory inputMemory;
+	SimInteropRing stateRing;
+	SimInteropRing inputRing;
+	SharedEvent stateEvent;
+};
+
+}
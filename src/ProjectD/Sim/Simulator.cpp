@@ -3,7 +3,11 @@
 #include "Sim/Track.h"
 #include "Car/Car.h"
 #include "Car/CarState.h"
+#include "Car/Tyre.h"
 #include "Core/SharedMemory.h"
+#include "Core/SharedEvent.h"
+#include "Core/StateArchive.h"
+#include "Core/FloatMode.h"
 
 namespace D {
 
@@ -52,6 +56,12 @@ bool Simulator::init(const std::wstring& _basePath)
 	interopEnabled = 0;
 	interopSyncState = 0;
 	interopSyncInput = 0;
+	interopRingSize = 16;
+
+	int iniSeed = 0;
+	deterministic = 0;
+	stateHashEnabled = 0;
+	batchTyreRays = 1;
 
 	auto ini(std::make_unique<INIReader>(basePath + L"cfg/sim.ini"));
 	if (ini->ready)
@@ -59,12 +69,43 @@ bool Simulator::init(const std::wstring& _basePath)
 		ini->tryGetInt(L"SIM", L"MAX_CARS", maxCars);
 		maxCars = tclamp(maxCars, 1, 100);
 
+		ini->tryGetInt(L"SIM", L"SEED", iniSeed);
+		ini->tryGetInt(L"SIM", L"DETERMINISTIC", deterministic);
+		ini->tryGetInt(L"SIM", L"STATE_HASH", stateHashEnabled);
+		ini->tryGetInt(L"SIM", L"BATCH_TYRE_RAYS", batchTyreRays);
+		ini->tryGetInt(L"SIM", L"DEBUG_COLLISIONS", maxDbgCollisions);
+
 		ini->tryGetFloat(L"ENVIRONMENT", L"ROAD_TEMP", roadTemperature);
 		ini->tryGetFloat(L"ENVIRONMENT", L"AMBIENT_TEMP", ambientTemperature);
 
 		ini->tryGetInt(L"INTEROP", L"ENABLED", interopEnabled);
 		ini->tryGetInt(L"INTEROP", L"SYNC_STATE", interopSyncState);
 		ini->tryGetInt(L"INTEROP", L"SYNC_INPUT", interopSyncInput);
+		ini->tryGetInt(L"INTEROP", L"RING_SIZE", interopRingSize);
+		interopRingSize = tclamp(interopRingSize, 1, 1024);
+
+		std::wstring spaceType;
+		if (ini->tryGetString(L"COLLISION_SPACE", L"STATIC", spaceType) && !parseCollisionSpaceType(spaceType, spaceConfig.staticType))
+			log_printf(L"UNKNOWN COLLISION_SPACE STATIC=%s", spaceType.c_str());
+		if (ini->tryGetString(L"COLLISION_SPACE", L"DYNAMIC", spaceType) && !parseCollisionSpaceType(spaceType, spaceConfig.dynamicType))
+			log_printf(L"UNKNOWN COLLISION_SPACE DYNAMIC=%s", spaceType.c_str());
+		ini->tryGetInt(L"COLLISION_SPACE", L"HASH_MIN_LEVEL", spaceConfig.hashMinLevel);
+		ini->tryGetInt(L"COLLISION_SPACE", L"HASH_MAX_LEVEL", spaceConfig.hashMaxLevel);
+		ini->tryGetInt(L"COLLISION_SPACE", L"QUADTREE_DEPTH", spaceConfig.quadTreeDepth);
+		spaceConfig.quadTreeDepth = tclamp(spaceConfig.quadTreeDepth, 1, 10);
+		ini->tryGetInt(L"COLLISION_SPACE", L"CAR_SAP", spaceConfig.carSweepAndPrune);
+
+		ini->tryGetInt(L"PHYSICS", L"QUICK_STEP", solverConfig.quickStep);
+		ini->tryGetInt(L"PHYSICS", L"QUICK_STEP_ITERATIONS", solverConfig.quickStepIterations);
+		ini->tryGetInt(L"PHYSICS", L"THREADS", solverConfig.numThreads);
+		ini->tryGetInt(L"PHYSICS", L"SHARED_THREAD_POOL", solverConfig.sharedThreadPool);
+		ini->tryGetInt(L"PHYSICS", L"MAX_PAIR_CONTACTS", solverConfig.maxPairContacts);
+		ini->tryGetFloat(L"PHYSICS", L"CONTACT_NORMAL_COS", solverConfig.contactNormalCos);
+		ini->tryGetInt(L"PHYSICS", L"CONTACT_POOL_SIZE", solverConfig.contactPoolSize);
+		solverConfig.quickStepIterations = tclamp(solverConfig.quickStepIterations, 1, 1000);
+		solverConfig.numThreads = tclamp(solverConfig.numThreads, 0, 64);
+		solverConfig.maxPairContacts = tmax(solverConfig.maxPairContacts, 0);
+		solverConfig.contactPoolSize = tclamp(solverConfig.contactPoolSize, 0, 65536);
 	}
 
 	dynamicTemp.baseRoad = roadTemperature;
@@ -72,17 +113,33 @@ bool Simulator::init(const std::wstring& _basePath)
 
 	physics = PhysicsFactory::createPhysicsEngine();
 	physics->setCollisionCallback(this);
+	physics->setCollisionSpaces(spaceConfig);
+	physics->setSolverConfig(solverConfig);
+
+	setSeed((uint64_t)iniSeed);
+	setDeterministic(deterministic != 0);
 
 	if (interopEnabled)
 	{
 		interopState.reset(new SharedMemory());
 		interopInput.reset(new SharedMemory());
 
-		const size_t stateSize = (sizeof(SimInteropHeader) + (sizeof(CarState) * maxCars));
-		const size_t inputSize = (sizeof(SimInteropHeader) + (sizeof(CarControls) * maxCars));
+		const size_t stateSize = SimInteropRing::computeSize(sizeof(CarState), maxCars, (uint32_t)interopRingSize);
+		const size_t inputSize = SimInteropRing::computeSize(sizeof(CarControls), maxCars, (uint32_t)interopRingSize);
+
+		interopState->allocate(SIM_INTEROP_STATE_NAME, stateSize);
+		interopInput->allocate(SIM_INTEROP_INPUT_NAME, inputSize);
+
+		if (interopState->isValid())
+		{
+			interopStateRing.create(interopState->data(), sizeof(CarState), maxCars, (uint32_t)interopRingSize, interopSyncState == 0);
+
+			interopStateEvent.reset(new SharedEvent());
+			interopStateEvent->create(SIM_INTEROP_STATE_EVENT_NAME, &interopStateRing.header->signalWord);
+		}
 
-		interopState->allocate(L"Local\\projectd_state", stateSize);
-		interopInput->allocate(L"Local\\projectd_input", inputSize);
+		if (interopInput->isValid())
+			interopInputRing.create(interopInput->data(), sizeof(CarControls), maxCars, (uint32_t)interopRingSize, interopSyncInput == 0);
 	}
 
 	log_printf(L"Simulator: init: DONE");
@@ -99,6 +156,23 @@ Track* Simulator::loadTrack(const std::wstring& trackName)
 	return track.get();
 }
 
+bool Simulator::cookTrack(const std::wstring& trackName)
+{
+	log_printf(L"Simulator: cookTrack: trackName=\"%s\"", trackName.c_str());
+
+	// source track shares physics world with a loaded one
+	if (track)
+	{
+		log_printf(L"cookTrack failed: unload track first");
+		return false;
+	}
+
+	auto source = std::make_shared<Track>(this);
+	source->init(trackName, false);
+
+	return source->cookPack(source->dataFolder + TRACK_PACK_FILE_NAME);
+}
+
 void Simulator::unloadTrack()
 {
 	log_printf(L"Simulator: unloadTrack");
@@ -165,18 +239,40 @@ void Simulator::removeCar(int carId)
 	}
 }
 
-void Simulator::step(float dt, double _physicsTime, double _gameTime)
+void Simulator::attachThread()
 {
 	const auto curThreadId = osGetCurrentThreadId();
-	if (curThreadId != physicsThreadId) // simulator init/step should be called by same thread
+	if (curThreadId == physicsThreadId)
+		return;
+
+	physicsThreadId = curThreadId;
+	physics->initThread();
+}
+
+struct SimulatorStepScope
+{
+	inline explicit SimulatorStepScope(std::atomic<bool>& _active) : active(_active) {}
+	inline ~SimulatorStepScope() { active.store(false, std::memory_order_release); }
+	std::atomic<bool>& active;
+};
+
+void Simulator::step(float dt, double _physicsTime, double _gameTime)
+{
+	// simulator can migrate between threads (worker pools), calls must not overlap
+	if (stepActive.exchange(true, std::memory_order_acquire))
 	{
-		log_printf(L"INVALID THREAD: curThreadId=%u physicsThreadId=%u", curThreadId, physicsThreadId);
+		log_printf(L"OVERLAPPING STEP: simulatorId=%d curThreadId=%u physicsThreadId=%u", simulatorId, osGetCurrentThreadId(), physicsThreadId);
 		SHOULD_NOT_REACH_FATAL;
 	}
+	SimulatorStepScope stepScope(stepActive);
+
+	attachThread();
 
 	if (!track)
 		return;
 
+	FloatModeGuard fpGuard(deterministic != 0);
+
 	deltaTime = dt;
 	physicsTime = _physicsTime;
 	gameTime = _gameTime;
@@ -193,13 +289,160 @@ void Simulator::step(float dt, double _physicsTime, double _gameTime)
 
 	evOnStepCompleted.fire(dt);
 
+	if (stateHashEnabled)
+		stateHash = computeStateHash();
+
 	// should be called after evOnStepCompleted
 	updateInteropState();
+}
+
+//=============================================================================
+
+static const uint32_t SimStateMagic = 0x53534450; // PDSS
+static const uint32_t SimStateVersion = 7;
+static const size_t SimStateSizeOffset = sizeof(uint32_t) * 2; // after magic and version
+
+void Simulator::saveState(std::vector<uint8_t>& buffer)
+{
+	StateArchive ar(buffer);
+	serializeState(ar);
+
+	const uint64_t stateSize = buffer.size();
+	memcpy(buffer.data() + SimStateSizeOffset, &stateSize, sizeof(stateSize));
+}
+
+bool Simulator::validateState(const void* data, size_t size) const
+{
+	const size_t headerSize = SimStateSizeOffset + sizeof(uint64_t) + sizeof(uint32_t) + sizeof(int32_t) * cars.size();
+	if (!track || size < headerSize)
+		return false;
+
+	StateArchive ar(data, size);
+	uint32_t magic = 0, version = 0, numCars = 0;
+	uint64_t stateSize = 0;
+
+	ar.io(magic);
+	ar.io(version);
+	ar.io(stateSize);
+	ar.io(numCars);
+
+	if (magic != SimStateMagic || version != SimStateVersion || stateSize != size || numCars != (uint32_t)cars.size())
+		return false;
+
+	for (auto* car : cars)
+	{
+		int32_t physicsGUID = 0;
+		ar.io(physicsGUID);
+		if (physicsGUID != car->physicsGUID)
+			return false;
+	}
+
+	return true;
+}
+
+bool Simulator::restoreState(const void* data, size_t size)
+{
+	// header and size are checked before anything is touched, no backup on the reset path
+	if (!validateState(data, size))
+	{
+		log_printf(L"restoreState failed: invalid header");
+		return false;
+	}
+
+	#if !defined(NDEBUG)
+	std::vector<uint8_t> backup;
+	saveState(backup);
+	#endif
+
+	try
+	{
+		StateArchive ar(data, size);
+		serializeState(ar);
+		GUARD_FATAL(ar.isEof());
+		return true;
+	}
+	catch (const std::exception& ex)
+	{
+		log_printf(L"restoreState failed: %S", ex.what());
+	}
 
-	if (dbgCollisions.size() > 500)
-		dbgCollisions.clear();
+	#if !defined(NDEBUG)
+	StateArchive ar(backup.data(), backup.size());
+	serializeState(ar);
+	#endif
+	return false;
 }
 
+void Simulator::serializeState(StateArchive& ar)
+{
+	GUARD_FATAL(track);
+
+	uint32_t magic = SimStateMagic;
+	uint32_t version = SimStateVersion;
+	uint64_t stateSize = 0; // patched by saveState
+	uint32_t numCars = (uint32_t)cars.size();
+
+	ar.io(magic);
+	ar.io(version);
+	ar.io(stateSize);
+	ar.io(numCars);
+
+	GUARD_FATAL(magic == SimStateMagic);
+	GUARD_FATAL(version == SimStateVersion);
+	GUARD_FATAL(numCars == (uint32_t)cars.size());
+
+	for (auto* car : cars)
+	{
+		int32_t physicsGUID = car->physicsGUID;
+		ar.io(physicsGUID);
+		GUARD_FATAL(physicsGUID == car->physicsGUID);
+	}
+
+	ar.io(deltaTime);
+	ar.io(physicsTime);
+	ar.io(gameTime);
+	ar.io(stepCounter);
+	ar.io(wind);
+	ar.io(rng);
+
+	track->serializeState(ar);
+	physics->serializeState(ar);
+
+	for (auto* car : cars)
+		car->serializeState(ar);
+}
+
+void Simulator::setSeed(uint64_t _seed)
+{
+	seed = _seed;
+	rng.seed(_seed);
+}
+
+void Simulator::setDeterministic(bool value)
+{
+	deterministic = value ? 1 : 0;
+	physics->setDeterministic(value);
+}
+
+void Simulator::setCollisionSpaces(const CollisionSpaceConfig& config)
+{
+	spaceConfig = config;
+	physics->setCollisionSpaces(config);
+}
+
+uint64_t Simulator::computeStateHash()
+{
+	// bodies, contacts and car states, buffer is reused between steps
+	StateArchive ar(stateHashBuffer);
+	physics->serializeState(ar);
+	for (auto* car : cars)
+		ar.io(*car->state);
+
+	return hashStateBytes(stateHashBuffer.data(), stateHashBuffer.size());
+}
+
+//=============================================================================
+
 void Simulator::stepWind(float dt)
 {
 	#if 0
@@ -230,101 +473,150 @@ void Simulator::stepCars(float dt)
 		pCar->stepPreCacheValues(dt);
 	}
 
+	if (batchTyreRays)
+	{
+		resolveTyreContacts();
+	}
+
 	for (auto* pCar : cars)
 	{
 		pCar->step(dt);
 	}
 }
 
-void Simulator::readInteropInputs() // sim is consumer
+void Simulator::resolveTyreContacts()
 {
-	if (!interopInput || !interopInput->isValid())
+	// hub bodies do not move until physics step, so contacts can be resolved before cars step,
+	// tyres of one car are adjacent which keeps ray packets coherent
+	tyreRayPos.clear();
+	tyreRayDir.clear();
+	tyreRayCaches.clear();
+
+	for (auto* pCar : cars)
+	{
+		for (auto& tyre : pCar->tyres)
+		{
+			vec3f pos, dir;
+			tyre->getContactRay(pos, dir);
+			tyreRayPos.emplace_back(pos);
+			tyreRayDir.emplace_back(dir);
+			tyreRayCaches.emplace_back(&tyre->contactCache);
+		}
+	}
+
+	if (tyreRayPos.empty())
 		return;
 
-	auto* sharedData = (uint8_t*)interopInput->data();
-	size_t pos = 0;
+	tyreRayHits.resize(tyreRayPos.size());
+	track->rayCastBatch(tyreRayPos.data(), tyreRayDir.data(), tyreRayPos.size(), cars[0]->tyres[0]->contactRayLength, tyreRayCaches.data(), tyreRayHits.data());
 
-	auto* header = (SimInteropHeader*)sharedData; pos += sizeof(SimInteropHeader);
-	const auto producerId = header->producerId;
+	size_t rayId = 0;
+	for (auto* pCar : cars)
+	{
+		for (auto& tyre : pCar->tyres)
+		{
+			tyre->setBatchContact(tyreRayPos[rayId], tyreRayHits[rayId]);
+			++rayId;
+		}
+	}
+}
+
+void Simulator::readInteropInputs() // sim is consumer
+{
+	if (!interopInputRing.isValid())
+		return;
 
-	// check if new frame available
-	if (interopSyncInput && (header->consumerId == producerId))
+	uint64_t index = 0;
+	const SimInteropFrame* frame = interopSyncInput ? interopInputRing.beginRead(index) : interopInputRing.beginReadLatest(index);
+	if (!frame)
 		return;
 
 	const int actualCars = tmin((int)cars.size(), (int)maxCars);
-	const int numCars =  tclamp((int)header->numCars, 0, actualCars);
+	const int numCars = tclamp((int)frame->numCars, 0, actualCars);
+	auto* items = (const CarControls*)interopInputRing.getItems(frame);
+
+	CarControls controls[100]; // maxCars is clamped to 100 in init
+	memcpy(controls, items, sizeof(CarControls) * numCars);
+
+	// frame was recycled by producer while copying
+	if (!interopInputRing.endRead(index))
+		return;
 
 	for (int carId = 0; carId < numCars; ++carId)
 	{
 		auto* pCar = cars[carId];
 
-		memcpy(&pCar->controls, sharedData + pos, sizeof(CarControls)); pos += sizeof(CarControls);
+		pCar->controls = controls[carId];
 		pCar->externalControls = true;
 	}
-
-	_mm_sfence();
-
-	header->consumerId = producerId;
 }
 
 void Simulator::updateInteropState() // sim is producer
 {
-	if (!interopState || !interopState->isValid())
+	if (!interopStateRing.isValid())
 		return;
 
-	auto* sharedData = (uint8_t*)interopState->data();
-	size_t pos = 0;
-
-	auto* header = (SimInteropHeader*)sharedData; pos += sizeof(SimInteropHeader);
-	const auto consumerId = header->consumerId;
-
-	// check if consumer received last frame
-	if (interopSyncState && (header->producerId != consumerId))
+	SimInteropFrame* frame = interopStateRing.beginWrite();
+	if (!frame)
 		return;
 
 	const int numCars = tmin((int)cars.size(), (int)maxCars);
-	header->numCars = (int32_t)numCars;
+	auto* items = (CarState*)interopStateRing.getItems(frame);
+
+	frame->stepId = stepCounter;
+	frame->physicsTime = physicsTime;
+	frame->numCars = (int32_t)numCars;
 
 	for (int carId = 0; carId < numCars; ++carId)
 	{
-		auto* pCar = cars[carId];
-
-		memcpy(sharedData + pos, pCar->state.get(), sizeof(CarState)); pos += sizeof(CarState);
+		memcpy(&items[carId], cars[carId]->state, sizeof(CarState));
 	}
 
-	_mm_sfence();
+	interopStateRing.endWrite();
 
-	++header->producerId;
+	if (interopStateRing.notify() && interopStateEvent->isValid())
+		interopStateEvent->signal();
 }
 
+//=============================================================================
+
 void Simulator::onCollisionCallback(
 	IRigidBody* rb0, ICollisionObject* shape0, 
 	IRigidBody* rb1, ICollisionObject* shape1, 
 	const vec3f& normal, const vec3f& pos, float depth)
 {
-	bool bFlag0 = false;
-	bool bFlag1 = false;
+	if ((int)dbgCollisions.size() < maxDbgCollisions)
+		dbgCollisions.push_back({pos, normal, depth, (float)physicsTime});
 
-	dbgCollisions.push_back({pos, normal, depth, (float)physicsTime});
-
-	for (auto* pCar : cars) // TODO: check
-	{
-		if (pCar->body.get() == rb0)
-			bFlag0 = true;
-
-		if (pCar->body.get() == rb1)
-			bFlag1 = true;
-	}
+	// car body user pointer is set by Car::init, other bodies have none
+	auto* pCar0 = rb0 ? (Car*)rb0->getUserPointer() : nullptr;
+	auto* pCar1 = rb1 ? (Car*)rb1->getUserPointer() : nullptr;
 
-	if (!bFlag0 && bFlag1)
+	if (!pCar0 && pCar1)
 	{
 		std::swap(rb0, rb1);
 		std::swap(shape0, shape1);
+		std::swap(pCar0, pCar1);
 	}
 
+	const CollisionEvent ev = {rb0, shape0, rb1, shape1, normal, pos, depth};
+
+	if (pCar0)
+		pCar0->pendingCollisions.push_back(ev);
+
+	if (pCar1 && pCar1 != pCar0)
+		pCar1->pendingCollisions.push_back(ev);
+}
+
+void Simulator::onCollisionStepCompleted()
+{
 	for (auto* pCar : cars)
 	{
-		pCar->onCollisionCallback(rb0, shape0, rb1, shape1, normal, pos, depth);
+		if (!pCar->pendingCollisions.empty())
+		{
+			pCar->onCollisionBatch(pCar->pendingCollisions.data(), pCar->pendingCollisions.size());
+			pCar->pendingCollisions.clear();
+		}
 	}
 }
 
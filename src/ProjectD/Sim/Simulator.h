@@ -2,7 +2,11 @@
 
 #include "Sim/SlipStream.h"
 #include "Core/Event.h"
+#include "Core/Random.h"
+#include "Sim/SimInterop.h"
+#include "Sim/ITrackRayCastProvider.h"
 #include <unordered_map>
+#include <atomic>
 
 namespace D {
 
@@ -35,13 +39,6 @@ struct CollisionData
 	float ts;
 };
 
-struct SimInteropHeader
-{
-	volatile uint64_t producerId = 0;
-	volatile uint64_t consumerId = 0;
-	volatile int32_t numCars = 0;
-};
-
 struct Simulator : public virtual ICollisionCallback // std::enable_shared_from_this<Simulator>
 {
 	Simulator();
@@ -51,18 +48,32 @@ struct Simulator : public virtual ICollisionCallback // std::enable_shared_from_
 
 	Track* loadTrack(const std::wstring& trackName);
 	void unloadTrack();
+	bool cookTrack(const std::wstring& trackName); // writes track package from source files, no track must be loaded
 
 	Car* addCar(const std::wstring& modelName);
 	Car* getCar(int carId);
 	void removeCar(int carId);
 
+	void attachThread();
 	void step(float dt, double physicsTime, double gameTime);
 
+	// snapshot of complete runtime state, restore requires the same track and cars
+	void saveState(std::vector<uint8_t>& buffer);
+	bool restoreState(const void* data, size_t size); // false if data is invalid, state is left unchanged unless data is corrupt past the header (debug builds roll back)
+	bool validateState(const void* data, size_t size) const; // header, size and cars match, does not touch state
+	void serializeState(StateArchive& ar);
+
+	void setSeed(uint64_t seed);
+	void setDeterministic(bool value);
+	void setCollisionSpaces(const CollisionSpaceConfig& config);
+	uint64_t computeStateHash();
+
 	// ICollisionCallback
 	void onCollisionCallback(
 		IRigidBody* rb0, ICollisionObject* shape0, 
 		IRigidBody* rb1, ICollisionObject* shape1, 
 		const vec3f& normal, const vec3f& pos, float depth) override;
+	void onCollisionStepCompleted() override;
 
 	void setDynamicTempData(const DynamicTempData& data);
 	void setWind(Speed speed, float directionDEG);
@@ -72,6 +83,7 @@ struct Simulator : public virtual ICollisionCallback // std::enable_shared_from_
 
 	void stepWind(float dt);
 	void stepCars(float dt);
+	void resolveTyreContacts();
 
 	Event<double> evOnPreStep;
 	Event<double> evOnStepCompleted;
@@ -102,8 +114,17 @@ struct Simulator : public virtual ICollisionCallback // std::enable_shared_from_
 	SteerMzLowSpeedReduction mzLowSpeedReduction;
 
 	int interopEnabled = 0;
-	int interopSyncState = 0;
-	int interopSyncInput = 0;
+	int interopSyncState = 0; // never overwrite unread state frames, drop new ones instead
+	int interopSyncInput = 0; // apply every input frame in order, otherwise only the latest one
+	int interopRingSize = 0; // frames per ring
+
+	uint64_t seed = 0;
+	int deterministic = 0; // pins FP control word and solver config for bit-exact replays
+	int stateHashEnabled = 0; // stateHash is updated after every step
+	int batchTyreRays = 0; // all tyre contact rays are cast in one batch before cars step
+	int maxDbgCollisions = 0; // dbgCollisions capacity, client clears it, 0: disabled
+	CollisionSpaceConfig spaceConfig;
+	PhysicsSolverConfig solverConfig;
 
 	// runtime
 
@@ -117,15 +138,28 @@ struct Simulator : public virtual ICollisionCallback // std::enable_shared_from_
 
 	std::unique_ptr<struct SharedMemory> interopState;
 	std::unique_ptr<struct SharedMemory> interopInput;
+	std::unique_ptr<struct SharedEvent> interopStateEvent;
+	SimInteropRing interopStateRing;
+	SimInteropRing interopInputRing;
 
 	int simulatorId = 0;
 	unsigned int physicsThreadId = 0;
+	std::atomic<bool> stepActive{false};
 	int carIdGenerator = 0;
 	float deltaTime = 0;
 	double physicsTime = 0;
 	double gameTime = 0;
 	unsigned int stepCounter = 0;
 
+	Random rng;
+	uint64_t stateHash = 0;
+	std::vector<uint8_t> stateHashBuffer;
+
+	std::vector<vec3f> tyreRayPos;
+	std::vector<vec3f> tyreRayDir;
+	std::vector<TrackRayCastHit> tyreRayHits;
+	std::vector<TrackContactCache*> tyreRayCaches;
+
 	std::unique_ptr<IAvatar> avatar;
 };
 
@@ -0,0 +1,206 @@
+#include "Sim/SimulatorPool.h"
+#include "Sim/Simulator.h"
+#include "Sim/Track.h"
+#include "Car/CarImpl.h"
+#include "Core/ThreadPool.h"
+
+namespace D {
+
+SimulatorPool::SimulatorPool()
+{
+	TRACE_CTOR(SimulatorPool);
+}
+
+SimulatorPool::~SimulatorPool()
+{
+	TRACE_DTOR(SimulatorPool);
+
+	threadPool.reset();
+	slots.clear();
+}
+
+void SimulatorPool::init(const SimulatorPoolConfig& _config)
+{
+	log_printf(L"SimulatorPool: init: numSimulators=%d track=\"%s\" car=\"%s\"",
+		_config.numSimulators, _config.trackName.c_str(), _config.carModel.c_str());
+
+	GUARD_FATAL(_config.numSimulators > 0);
+	GUARD_FATAL(_config.substeps > 0);
+
+	config = _config;
+	slots.resize(config.numSimulators);
+
+	// sequential, loaders share INIReader cache
+	for (int i = 0; i < config.numSimulators; ++i)
+	{
+		auto& slot = slots[i];
+
+		slot.sim = std::make_shared<Simulator>();
+		slot.sim->simulatorId = i;
+		slot.sim->init(config.basePath);
+		slot.sim->setSeed(config.seed + (uint64_t)i);
+		slot.sim->setDeterministic(config.deterministic);
+		slot.sim->loadTrack(config.trackName);
+
+		slot.car = slot.sim->addCar(config.carModel);
+		GUARD_FATAL(slot.car);
+
+		slot.car->smoothSteer = config.smoothSteer;
+		slot.car->autoClutch->useAutoOnStart = config.autoClutch;
+		slot.car->autoClutch->useAutoOnChange = config.autoClutch;
+		slot.car->autoShift->isActive = config.autoShift;
+		slot.car->autoBlip->isActive = config.autoBlip;
+	}
+
+	auto* car = slots[0].car;
+	numLookAhead = (int)car->lookAhead.size();
+	numProbes = (int)car->probes.size();
+	numProfileSamples = (int)car->lookAheadProfile.size();
+	observationSize = 12 + numLookAhead + numProbes + numProfileSamples * TrackProfileSample::NumFeatures;
+
+	threadPool.reset(new ThreadPool(config.numThreads));
+
+	log_printf(L"SimulatorPool: init: DONE observationSize=%d", observationSize);
+}
+
+void SimulatorPool::reset(float* obs)
+{
+	threadPool->parallelFor(slots.size(), [this, obs](size_t i)
+	{
+		resetSimulator((int)i, obs + i * observationSize);
+	});
+}
+
+void SimulatorPool::resetSimulator(int index, float* obs)
+{
+	auto& slot = slots[index];
+
+	slot.sim->attachThread();
+	slot.car->teleportByMode((TeleportMode)config.teleportMode);
+	slot.car->controls = CarControls();
+	slot.episodeReward = 0;
+	slot.episodeSteps = 0;
+
+	// settle single step to refresh CarState
+	advance(slot, 1);
+
+	if (obs)
+		packObservation(slot.car, obs);
+}
+
+void SimulatorPool::step(const CarControls* controls, float* obs, float* rewards, uint8_t* dones, float* terminalObs)
+{
+	threadPool->parallelFor(slots.size(), [=](size_t i)
+	{
+		stepSlot(i, controls[i], obs + i * observationSize, rewards[i], dones[i], terminalObs ? terminalObs + i * observationSize : nullptr);
+	});
+}
+
+void SimulatorPool::stepSlot(size_t index, const CarControls& controls, float* obs, float& reward, uint8_t& done, float* terminalObs)
+{
+	auto& slot = slots[index];
+	auto* car = slot.car;
+	auto* state = car->state;
+
+	car->controls = controls;
+	reward = 0;
+
+	for (int i = 0; i < config.substeps; ++i)
+	{
+		advance(slot, 1);
+		reward += state->stepReward;
+
+		if ((config.terminateOnHit && state->collisionFlag) || (config.terminateOffTrack && state->outOfTrackFlag))
+			break;
+	}
+
+	bool terminate = false;
+
+	if (config.terminateOnHit && state->collisionFlag)
+	{
+		reward -= config.terminateHitPenalty;
+		terminate = true;
+	}
+
+	if (config.terminateOffTrack && state->outOfTrackFlag)
+	{
+		reward -= config.terminateOffTrackPenalty;
+		terminate = true;
+	}
+
+	if (config.terminateWhenStuck && (state->lastTrackPointTimestamp + config.stuckTimeout < state->timestamp))
+	{
+		reward -= config.terminateStuckPenalty;
+		terminate = true;
+	}
+
+	slot.episodeReward += reward;
+	slot.episodeSteps++;
+
+	if (slot.episodeReward < config.terminateLowReward)
+		terminate = true;
+
+	done = terminate ? 1 : 0;
+	packObservation(car, obs);
+
+	if (terminate && config.autoReset)
+	{
+		if (terminalObs)
+			memcpy(terminalObs, obs, sizeof(float) * observationSize);
+
+		resetSimulator((int)index, obs);
+	}
+}
+
+void SimulatorPool::advance(Slot& slot, int substeps)
+{
+	auto* sim = slot.sim.get();
+	const double dt = config.dt;
+
+	for (int i = 0; i < substeps; ++i)
+	{
+		sim->step(config.dt, sim->physicsTime, sim->gameTime);
+		sim->physicsTime += dt;
+		sim->gameTime += dt;
+	}
+}
+
+void SimulatorPool::packObservation(const Car* car, float* obs) const
+{
+	const auto* state = car->state;
+	int n = 0;
+
+	obs[n++] = state->localVelocity.x;
+	obs[n++] = state->localVelocity.y;
+	obs[n++] = state->localVelocity.z;
+
+	obs[n++] = state->localAngularVelocity.x;
+	obs[n++] = state->localAngularVelocity.y;
+	obs[n++] = state->localAngularVelocity.z;
+
+	for (int i = 0; i < 4; ++i)
+		obs[n++] = state->tyreNdSlip[i];
+
+	obs[n++] = state->bodyVsTrack;
+	obs[n++] = state->velocityVsTrack;
+
+	const size_t numLookAhead = tmin(car->lookAhead.size(), (size_t)CarState::MaxLookAhead);
+	for (size_t i = 0; i < car->lookAhead.size(); ++i)
+		obs[n++] = (i < numLookAhead) ? state->lookAhead[i] : 0.0f;
+
+	const size_t numProbes = tmin(car->probes.size(), (size_t)CarState::MaxProbes);
+	for (size_t i = 0; i < car->probes.size(); ++i)
+		obs[n++] = (i < numProbes) ? state->probes[i] : 0.0f;
+
+	for (const auto& s : car->lookAheadProfile)
+	{
+		obs[n++] = s.curvature;
+		obs[n++] = s.heading;
+		obs[n++] = s.width;
+		obs[n++] = s.elevation;
+		obs[n++] = s.banking;
+		obs[n++] = s.grip;
+	}
+}
+
+}
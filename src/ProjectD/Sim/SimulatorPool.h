@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Sim/SimulatorCommon.h"
+#include "Car/CarControls.h"
+#include <vector>
+#include <string>
+
+namespace D {
+
+struct SimulatorPoolConfig
+{
+	std::wstring basePath;
+	std::wstring trackName;
+	std::wstring carModel;
+
+	int numSimulators = 1;
+	int numThreads = 0; // 0: hardware concurrency
+	int substeps = 1;
+	float dt = 1.0f / 333.0f;
+
+	uint64_t seed = 0; // simulator i is seeded with seed + i
+	bool deterministic = false;
+
+	bool smoothSteer = true;
+	bool autoClutch = true;
+	bool autoShift = true;
+	bool autoBlip = true;
+
+	int teleportMode = 0; // TeleportMode
+	bool autoReset = true;
+
+	bool terminateOnHit = true;
+	bool terminateOffTrack = true;
+	bool terminateWhenStuck = true;
+	float terminateHitPenalty = 50.0f;
+	float terminateOffTrackPenalty = 50.0f;
+	float terminateStuckPenalty = 50.0f;
+	float terminateLowReward = -200.0f;
+	float stuckTimeout = 5.0f;
+};
+
+// Owns N independent simulators (own track and car), steps them in parallel on work-stealing pool.
+// Observation layout: localVelocity[3], localAngularVelocity[3], tyreNdSlip[4], bodyVsTrack, velocityVsTrack, lookAhead[N], probes[N],
+// lookAheadProfile[N][curvature, heading, width, elevation, banking, grip] (empty unless [CAR_LOOK_AHEAD] PROFILE_COUNT > 0)
+struct SimulatorPool : public NonCopyable
+{
+	SimulatorPool();
+	~SimulatorPool();
+
+	void init(const SimulatorPoolConfig& config);
+
+	// obs: [numSimulators * observationSize]
+	void reset(float* obs);
+	void resetSimulator(int index, float* obs);
+
+	// controls: [numSimulators], terminalObs is optional and receives last observation of finished episodes before auto reset
+	void step(const CarControls* controls, float* obs, float* rewards, uint8_t* dones, float* terminalObs = nullptr);
+
+	int getSimulatorCount() const { return (int)slots.size(); }
+	int getObservationSize() const { return observationSize; }
+	int getLookAheadCount() const { return numLookAhead; }
+	int getProbeCount() const { return numProbes; }
+	int getProfileCount() const { return numProfileSamples; }
+	Simulator* getSimulator(int index) const { return slots[index].sim.get(); }
+	Car* getCar(int index) const { return slots[index].car; }
+
+	// internals
+
+	struct Slot
+	{
+		SimulatorPtr sim;
+		Car* car = nullptr;
+		float episodeReward = 0;
+		int episodeSteps = 0;
+	};
+
+	void stepSlot(size_t index, const CarControls& controls, float* obs, float& reward, uint8_t& done, float* terminalObs);
+	void advance(Slot& slot, int substeps);
+	void packObservation(const Car* car, float* obs) const;
+
+	SimulatorPoolConfig config;
+	std::vector<Slot> slots;
+	std::unique_ptr<struct ThreadPool> threadPool;
+	int observationSize = 0;
+	int numLookAhead = 0;
+	int numProbes = 0;
+	int numProfileSamples = 0;
+};
+
+}
@@ -22,6 +22,9 @@ struct Surface : public virtual IObject
 	uint8_t isPitlane = 0;
 };
 
+#define BLOB_SURFACE_MAGIC 0xAABBCCDD
+#define BLOB_SURFACE_MAGIC_INDEX32 0xAABBCCEE // followed by 32-bit indices
+
 #pragma pack(push, 1)
 struct BlobSurface
 {
@@ -1,6 +1,9 @@
 #include "Sim/Track.h"
 #include "Sim/Simulator.h"
 #include "Core/DebugGL.h"
+#include "Core/StateArchive.h"
+#include "Core/ThreadPool.h"
+#include "Core/CpuFeatures.h"
 
 #define TRACK_DEBUG_DRAW 0
 
@@ -12,6 +15,29 @@
 
 namespace D {
 
+// Tyre ray caster backed by track BVH, keeps IRayCaster contract of the physics engine
+struct TrackRayCaster : public IRayCaster
+{
+	TrackRayCaster(const Track* _track, float _length) : track(_track), length(_length) {}
+
+	RayCastHit rayCast(const vec3f& pos, const vec3f& dir) override
+	{
+		RayCastHit hit;
+		track->rayCastBVH(pos, dir, length, hit);
+		return hit;
+	}
+
+	void rayCastBatch(const vec3f* pos, const vec3f* dir, size_t count, RayCastHit* hits) override
+	{
+		track->rayCastBatchBVH(pos, dir, count, length, hits);
+	}
+
+	const Track* track = nullptr;
+	float length = 0;
+};
+
+//=============================================================================
+
 Track::Track(Simulator* _sim)
 {
 	TRACE_CTOR(Track);
@@ -22,9 +48,12 @@ Track::Track(Simulator* _sim)
 Track::~Track()
 {
 	TRACE_DTOR(Track);
+
+	if (contactCacheHits + contactCacheMisses)
+		log_printf(L"Track: contact cache: hits=%llu misses=%llu", (unsigned long long)contactCacheHits, (unsigned long long)contactCacheMisses);
 }
 
-bool Track::init(const std::wstring& trackName)
+bool Track::init(const std::wstring& trackName, bool allowPack)
 {
 	log_printf(L"Track: init: trackName=\"%s\"", trackName.c_str());
 
@@ -39,11 +68,30 @@ bool Track::init(const std::wstring& trackName)
 	if (ini->ready)
 	{
 		ini->tryGetFloat(L"ENVIRONMENT", L"TRACK_GRIP", dynamicGripLevel);
+		ini->tryGetInt(L"TRACK_BVH", L"ENABLED", useBVH);
+		ini->tryGetInt(L"TRACK_MESH", L"MERGE_SURFACES", mergeSurfaces);
+		ini->tryGetInt(L"TRACK_BVH", L"CONTACT_CACHE", useContactCache);
+		ini->tryGetFloat(L"TRACK_BVH", L"CONTACT_CACHE_MARGIN", contactCacheMargin);
+		ini->tryGetInt(L"TRACK_BVH", L"CONTACT_CACHE_MAX_TRIANGLES", contactCacheMaxTriangles);
+		ini->tryGetInt(L"TRACK_PACK", L"ENABLED", usePack);
+		ini->tryGetInt(L"TRACK_TRACE", L"THREADS", traceThreads);
+		ini->tryGetFloat(L"TRACK_TRACE", L"CHECKPOINT_SECONDS", traceCheckpointSeconds);
+		ini->tryGetFloat(L"TRACK_TRACE", L"TIME_BUDGET", traceTimeBudget);
+		ini->tryGetInt(L"TRACK_SDF", L"ENABLED", useDistanceField);
+		ini->tryGetFloat(L"TRACK_SDF", L"CELL_SIZE", distanceFieldCellSize);
+		ini->tryGetFloat(L"TRACK_SDF", L"MAX_DISTANCE", distanceFieldMaxDistance);
 	}
 
-	loadSurfaceBlob();
-	loadPits();
-	initTrackPoints();
+	// cooked package must not contain partially traced fat points
+	if (!allowPack)
+		traceTimeBudget = 0;
+
+	if (!(allowPack && usePack && loadPack(dataFolder + TRACK_PACK_FILE_NAME)))
+	{
+		loadSurfaceBlob();
+		loadPits();
+		initTrackPoints();
+	}
 
 	log_printf(L"Track: init: DONE");
 	return true;
@@ -55,19 +103,198 @@ void Track::step(float dt) // TODO?
 
 IRayCasterPtr Track::createRayCaster(float length)
 {
+	if (bvh.isValid())
+		return std::make_shared<TrackRayCaster>(this, length);
+
 	return sim->physics->createRayCaster(length);
 }
 
+bool Track::rayCastBVH(const vec3f& org, const vec3f& dir, float length, RayCastHit& result) const
+{
+	// ODE normalizes ray direction as well
+	const vec3f unitDir = dir.get_norm();
+
+	TrackBVH::Hit hit;
+	if (!bvh.rayCast(org, unitDir, length, hit))
+		return false;
+
+	const auto& tri = bvh.triangles[hit.triangle];
+	result.collisionObject = meshes[surfaceMeshes[tri.surfaceIndex]]->collider.get();
+	result.triangle = tri.meshTriangle;
+	result.pos = org + unitDir * hit.t;
+	result.normal = bvh.getNormal(hit.triangle, unitDir);
+	result.hasContact = true;
+	return true;
+}
+
+void Track::rayCastBatchBVH(const vec3f* org, const vec3f* dir, size_t count, float length, RayCastHit* hits) const
+{
+	const int PacketSize = TrackBVH::PacketSize;
+	vec3f unitDir[PacketSize];
+	TrackBVH::Hit packetHits[PacketSize];
+	uint8_t packetHasHit[PacketSize];
+
+	for (size_t first = 0; first < count; first += PacketSize)
+	{
+		const int n = (int)tmin(count - first, (size_t)PacketSize);
+
+		for (int i = 0; i < n; ++i)
+			unitDir[i] = dir[first + i].get_norm();
+
+		bvh.rayCastPacket(org + first, unitDir, n, length, packetHits, packetHasHit);
+
+		for (int i = 0; i < n; ++i)
+		{
+			auto& result = hits[first + i];
+			if (packetHasHit[i])
+			{
+				const auto& hit = packetHits[i];
+				const auto& tri = bvh.triangles[hit.triangle];
+				result.collisionObject = meshes[surfaceMeshes[tri.surfaceIndex]]->collider.get();
+				result.triangle = tri.meshTriangle;
+				result.pos = org[first + i] + unitDir[i] * hit.t;
+				result.normal = bvh.getNormal(hit.triangle, unitDir[i]);
+				result.hasContact = true;
+			}
+			else
+			{
+				result = RayCastHit();
+			}
+		}
+	}
+}
+
+bool Track::rayCastCached(TrackContactCache& cache, const vec3f& org, const vec3f& dir, float length, TrackRayCastHit& result)
+{
+	const vec3f unitDir = dir.get_norm();
+	const vec3f end = org + unitDir * length;
+	const vec3f segMin(tmin(org.x, end.x), tmin(org.y, end.y), tmin(org.z, end.z));
+	const vec3f segMax(tmax(org.x, end.x), tmax(org.y, end.y), tmax(org.z, end.z));
+
+	const bool inside = cache.valid
+		&& segMin.x >= cache.bmin.x && segMin.y >= cache.bmin.y && segMin.z >= cache.bmin.z
+		&& segMax.x <= cache.bmax.x && segMax.y <= cache.bmax.y && segMax.z <= cache.bmax.z;
+
+	if (!inside)
+	{
+		contactCacheMisses++;
+		cache.valid = false;
+
+		// shrink margin until local set is small enough, dense geometry (kerbs, walls) falls back to full query
+		for (float margin = contactCacheMargin; margin >= contactCacheMargin * 0.125f; margin *= 0.5f)
+		{
+			const vec3f bmin = segMin - vec3f(margin, margin, margin);
+			const vec3f bmax = segMax + vec3f(margin, margin, margin);
+			if (bvh.queryBox(bmin, bmax, cache.triangles, (size_t)contactCacheMaxTriangles))
+			{
+				cache.bmin = bmin;
+				cache.bmax = bmax;
+				cache.valid = true;
+				break;
+			}
+		}
+
+		// resolved by caller with full query, same result as local set (no FP contraction, same operation order)
+		return false;
+	}
+
+	contactCacheHits++;
+
+	TrackBVH::Hit hit;
+	if (bvh.rayCastList(cache.triangles.data(), cache.triangles.size(), org, unitDir, length, hit))
+	{
+		const auto& tri = bvh.triangles[hit.triangle];
+		result.collisionObject = meshes[surfaceMeshes[tri.surfaceIndex]]->collider.get();
+		result.triangle = tri.meshTriangle;
+		result.surface = surfaces[tri.surfaceIndex].get();
+		result.pos = org + unitDir * hit.t;
+		result.normal = bvh.getNormal(hit.triangle, unitDir);
+		result.hasContact = true;
+	}
+	else
+	{
+		result = TrackRayCastHit();
+	}
+	return true;
+}
+
+void Track::rayCastBatch(const vec3f* org, const vec3f* dir, size_t count, float length, TrackContactCache* const* caches, TrackRayCastHit* hits)
+{
+	if (!bvh.isValid())
+	{
+		for (size_t i = 0; i < count; ++i)
+			rayCast(org[i], dir[i], length, hits[i]);
+		return;
+	}
+
+	if (caches && useContactCache)
+	{
+		contactMissIds.clear();
+		contactMissPos.clear();
+		contactMissDir.clear();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!rayCastCached(*caches[i], org[i], dir[i], length, hits[i]))
+			{
+				contactMissIds.push_back(i);
+				contactMissPos.push_back(org[i]);
+				contactMissDir.push_back(dir[i]);
+			}
+		}
+
+		// cache misses are traversed together as packets
+		if (!contactMissIds.empty())
+		{
+			contactMissHits.resize(contactMissIds.size());
+			rayCastBatchBVH(contactMissPos.data(), contactMissDir.data(), contactMissIds.size(), length, contactMissHits.data());
+
+			for (size_t i = 0; i < contactMissIds.size(); ++i)
+			{
+				auto& result = hits[contactMissIds[i]];
+				static_cast<RayCastHit&>(result) = contactMissHits[i];
+				result.surface = getHitSurface(contactMissHits[i]);
+			}
+		}
+		return;
+	}
+
+	// TrackRayCastHit is not contiguous RayCastHit array, resolve in packet sized chunks
+	const size_t Chunk = TrackBVH::PacketSize * 4;
+	RayCastHit chunkHits[Chunk];
+
+	for (size_t first = 0; first < count; first += Chunk)
+	{
+		const size_t n = tmin(count - first, Chunk);
+		rayCastBatchBVH(org + first, dir + first, n, length, chunkHits);
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			auto& result = hits[first + i];
+			static_cast<RayCastHit&>(result) = chunkHits[i];
+			result.surface = getHitSurface(chunkHits[i]);
+		}
+	}
+}
+
 bool Track::rayCast(const vec3f& org, const vec3f& dir, float length, TrackRayCastHit& result)
 {
+	if (bvh.isValid())
+	{
+		memzero(result);
+		if (rayCastBVH(org, dir, length, result))
+		{
+			result.surface = getHitSurface(result);
+			return true;
+		}
+		return false;
+	}
+
 	auto hit = sim->physics->rayCast(org, dir, length);
 	if (hit.hasContact)
 	{
-		result.surface = (Surface*)hit.collisionObject->getUserPointer();
-		result.collisionObject = hit.collisionObject;
-		result.pos = hit.pos;
-		result.normal = hit.normal;
-		result.hasContact = hit.hasContact;
+		static_cast<RayCastHit&>(result) = hit;
+		result.surface = getHitSurface(hit);
 	}
 	else
 	{
@@ -76,16 +303,23 @@ bool Track::rayCast(const vec3f& org, const vec3f& dir, float length, TrackRayCa
 	return hit.hasContact;
 }
 
+Surface* Track::getHitSurface(const RayCastHit& hit)
+{
+	if (!hit.hasContact)
+		return nullptr;
+
+	const auto* mesh = (const TrackMesh*)hit.collisionObject->getUserPointer();
+	const uint32_t surfaceIndex = mesh->triangleSurfaces.empty() ? mesh->surfaceIndex : mesh->triangleSurfaces[hit.triangle];
+	return surfaces[surfaceIndex].get();
+}
+
 bool Track::rayCastWithRayCaster(const vec3f& org, const vec3f& dir, IRayCasterPtr rayCaster, TrackRayCastHit& result)
 {
 	auto hit = rayCaster->rayCast(org, dir);
 	if (hit.hasContact)
 	{
-		result.surface = (Surface*)hit.collisionObject->getUserPointer();
-		result.collisionObject = hit.collisionObject;
-		result.pos = hit.pos;
-		result.normal = hit.normal;
-		result.hasContact = hit.hasContact;
+		static_cast<RayCastHit&>(result) = hit;
+		result.surface = getHitSurface(hit);
 	}
 	else
 	{
@@ -94,10 +328,296 @@ bool Track::rayCastWithRayCaster(const vec3f& org, const vec3f& dir, IRayCasterP
 	return hit.hasContact;
 }
 
+// 0 when file is missing
+// reads the whole file on every pack load, cheap next to loading surfaces.bin itself but not free for large tracks
+static uint64_t hashSourceFile(const std::wstring& path)
+{
+	MappedFile file;
+	return file.open(path.c_str()) ? hashStateBytes(file.data(), file.size()) : 0;
+}
+
+bool Track::loadPack(const std::wstring& path)
+{
+	auto newPack = std::make_unique<TrackPack>();
+	if (!newPack->open(path.c_str()))
+		return false;
+
+	log_printf(L"loadPack: %s", path.c_str());
+
+	// sources are optional, packages can be shipped alone
+	const uint64_t surfacesHash = hashSourceFile(dataFolder + L"surfaces.bin");
+	const uint64_t splineHash = hashSourceFile(dataFolder + L"spline.bin");
+	if ((surfacesHash && surfacesHash != newPack->header->sourceSurfacesHash) || (splineHash && splineHash != newPack->header->sourceSplineHash))
+	{
+		log_printf(L"loadPack: package is stale, cook it again");
+		return false;
+	}
+
+	if (loadSplineConfig() && computeTraceSettingsHash() != newPack->header->configHash)
+	{
+		log_printf(L"loadPack: package was traced with different spline.ini settings, cook it again");
+		return false;
+	}
+
+	size_t numInfo = 0, numSurfaces = 0, numVertices = 0, numIndices = 0;
+	const auto* info = newPack->get<TrackPackInfo>(TrackPackSectionId::Info, numInfo);
+	const auto* packSurfaces = newPack->get<TrackPackSurface>(TrackPackSectionId::Surfaces, numSurfaces);
+	const auto* vertices = newPack->get<TriMeshVertex>(TrackPackSectionId::Vertices, numVertices);
+	const auto* indices = newPack->get<TriMeshIndex>(TrackPackSectionId::Indices, numIndices);
+
+	if (!info || numInfo != 1 || !packSurfaces || !vertices || !indices)
+	{
+		log_printf(L"loadPack: missing sections");
+		return false;
+	}
+
+	for (size_t i = 0; i < numSurfaces; ++i)
+	{
+		const auto& ps = packSurfaces[i];
+		bool valid = ps.numVertices && ps.numIndices && (ps.numIndices % 3) == 0
+			&& (size_t)ps.firstVertex + ps.numVertices <= numVertices && (size_t)ps.firstIndex + ps.numIndices <= numIndices;
+
+		for (uint32_t k = 0; valid && k < ps.numIndices; ++k)
+			valid = indices[ps.firstIndex + k] < ps.numVertices;
+
+		if (!valid)
+		{
+			log_printf(L"loadPack: invalid surface %d", (int)i);
+			return false;
+		}
+	}
+
+	size_t numNodes = 0, numTriangles = 0, numPits = 0, numSlim = 0, numFat = 0, numDistances = 0;
+	size_t numSplinePoints = 0, numSplineNodes = 0, numSplineDistances = 0;
+	const auto* nodes = newPack->get<TrackBVH::Node>(TrackPackSectionId::BvhNodes, numNodes);
+	const auto* triangles = newPack->get<TrackBVH::Triangle>(TrackPackSectionId::BvhTriangles, numTriangles);
+	const auto* packPits = newPack->get<mat44f>(TrackPackSectionId::Pits, numPits);
+	const auto* slim = newPack->get<SlimTrackPoint>(TrackPackSectionId::SlimPoints, numSlim);
+	const auto* fat = newPack->get<FatTrackPoint>(TrackPackSectionId::FatPoints, numFat);
+	const auto* distances = newPack->get<float>(TrackPackSectionId::FatPointDistances, numDistances);
+	const auto* splinePoints = newPack->get<vec3f>(TrackPackSectionId::SplinePoints, numSplinePoints);
+	const auto* splineNodes = newPack->get<vec3f>(TrackPackSectionId::SplineNodes, numSplineNodes);
+	const auto* splineDistances = newPack->get<float>(TrackPackSectionId::SplineDistances, numSplineDistances);
+
+	size_t numFieldInfo = 0, numFieldTiles = 0, numFieldCells = 0;
+	const auto* fieldInfo = newPack->get<TrackDistanceFieldInfo>(TrackPackSectionId::DistanceFieldInfo, numFieldInfo);
+	const auto* fieldTiles = newPack->get<uint32_t>(TrackPackSectionId::DistanceFieldTiles, numFieldTiles);
+	const auto* fieldCells = newPack->get<int8_t>(TrackPackSectionId::DistanceFieldCells, numFieldCells);
+
+	if (numFat && (numDistances != numFat || !numSplineNodes || numSplineDistances != numSplineNodes))
+	{
+		log_printf(L"loadPack: invalid spline sections");
+		return false;
+	}
+
+	// BVH triangles refer to collider mesh triangles, rebuild when merge mode differs
+	const bool packBVH = useBVH && nodes && numNodes && triangles && (info->mergeSurfaces != 0) == (mergeSurfaces != 0);
+	if (packBVH)
+	{
+		bool valid = TrackBVH::validate(nodes, numNodes, numTriangles);
+		for (size_t i = 0; valid && i < numTriangles; ++i)
+			valid = triangles[i].surfaceIndex < numSurfaces;
+
+		if (!valid)
+		{
+			log_printf(L"loadPack: invalid BVH sections");
+			return false;
+		}
+	}
+
+	meshes.clear();
+	surfaceMeshes.clear();
+	surfaces.clear();
+	bvh.clear();
+
+	pack = std::move(newPack);
+
+	for (size_t i = 0; i < numSurfaces; ++i)
+	{
+		const auto& ps = packSurfaces[i];
+
+		auto trimesh = sim->physics->createTriMesh();
+		trimesh->setView(vertices + ps.firstVertex, ps.numVertices, indices + ps.firstIndex, ps.numIndices);
+
+		auto pSurf = std::make_shared<Surface>();
+		pSurf->trimesh = trimesh;
+		pSurf->sectorID = ps.sectorID;
+		pSurf->collisionCategory = ps.collisionCategory;
+		pSurf->gripMod = ps.gripMod;
+		pSurf->damping = ps.damping;
+		pSurf->sinHeight = ps.sinHeight;
+		pSurf->sinLength = ps.sinLength;
+		pSurf->granularity = ps.granularity;
+		pSurf->dirtAdditiveK = ps.dirtAdditiveK;
+		pSurf->vibrationGain = ps.vibrationGain;
+		pSurf->vibrationLength = ps.vibrationLength;
+		pSurf->wavPitchSpeed = ps.wavPitchSpeed;
+		pSurf->isValidTrack = ps.isValidTrack;
+		pSurf->isPitlane = ps.isPitlane;
+
+		surfaces.emplace_back(std::move(pSurf));
+	}
+
+	boundsMin = info->boundsMin;
+	boundsMax = info->boundsMax;
+
+	initSurfaceMeshes(useBVH && !packBVH);
+
+	if (packBVH)
+	{
+		// mesh triangle counts are known once colliders are built
+		for (size_t i = 0; i < numTriangles; ++i)
+		{
+			const auto& tri = triangles[i];
+			const auto* mesh = meshes[surfaceMeshes[tri.surfaceIndex]].get();
+			auto* trimesh = mesh->trimesh ? mesh->trimesh.get() : surfaces[tri.surfaceIndex]->trimesh.get();
+			if (tri.meshTriangle >= trimesh->getIndexCount() / 3)
+			{
+				log_printf(L"loadPack: invalid BVH triangle %d", (int)i);
+				meshes.clear();
+				surfaceMeshes.clear();
+				surfaces.clear();
+				pack.reset();
+				return false;
+			}
+		}
+
+		bvh.nodes.assign(nodes, nodes + numNodes);
+		bvh.triangles.assign(triangles, triangles + numTriangles);
+	}
+
+	pits.assign(packPits, packPits + numPits);
+	slimPoints.assign(slim, slim + numSlim);
+	fatPoints.assign(fat, fat + numFat);
+	fatPointDistances.assign(distances, distances + numDistances);
+
+	closedLoop = info->closedLoop != 0;
+	interpolateStep = info->interpolateStep;
+	computedTrackWidth = info->computedTrackWidth;
+	computedTrackLength = info->computedTrackLength;
+
+	interpolatedSpline.reset();
+	arcSpline.clear();
+	profile.clear();
+	boundsSegments.clear();
+	distanceField.clear();
+
+	if (!fatPoints.empty())
+	{
+		initFatPointsGrid();
+		initBoundsSegments();
+
+		interpolatedSpline.reset(new BSpline3d());
+		interpolatedSpline->_points.assign(splinePoints, splinePoints + numSplinePoints);
+		interpolatedSpline->_nodes.assign(splineNodes, splineNodes + numSplineNodes);
+		interpolatedSpline->_distances.assign(splineDistances, splineDistances + numSplineDistances);
+		interpolatedSpline->_steps = info->splineSteps;
+		interpolatedSpline->_closed_loop = closedLoop;
+		initArcSpline();
+		initProfile();
+
+		if (useDistanceField)
+		{
+			// rebake when sim.ini asks for different resolution
+			const bool fieldMatches = fieldInfo && numFieldInfo == 1 && fieldInfo->cellSize == distanceFieldCellSize && fieldInfo->maxDistance == distanceFieldMaxDistance;
+			if (!(fieldMatches && distanceField.assign(*fieldInfo, fieldTiles, numFieldTiles, fieldCells, numFieldCells)))
+				initDistanceField();
+		}
+	}
+
+	log_printf(L"loadPack: surfaces=%d vertices=%d bvhNodes=%d fatPoints=%d", (int)numSurfaces, (int)numVertices, (int)bvh.nodes.size(), (int)numFat);
+	return true;
+}
+
+bool Track::cookPack(const std::wstring& path)
+{
+	log_printf(L"cookPack: %s", path.c_str());
+
+	std::vector<TrackPackSurface> packSurfaces;
+	std::vector<TriMeshVertex> vertices;
+	std::vector<TriMeshIndex> indices;
+
+	for (const auto& pSurf : surfaces)
+	{
+		auto* trimesh = pSurf->trimesh.get();
+
+		TrackPackSurface ps;
+		ps.firstVertex = (uint32_t)vertices.size();
+		ps.numVertices = (uint32_t)trimesh->getVertexCount();
+		ps.firstIndex = (uint32_t)indices.size();
+		ps.numIndices = (uint32_t)trimesh->getIndexCount();
+		ps.sectorID = pSurf->sectorID;
+		ps.collisionCategory = pSurf->collisionCategory;
+		ps.gripMod = pSurf->gripMod;
+		ps.damping = pSurf->damping;
+		ps.sinHeight = pSurf->sinHeight;
+		ps.sinLength = pSurf->sinLength;
+		ps.granularity = pSurf->granularity;
+		ps.dirtAdditiveK = pSurf->dirtAdditiveK;
+		ps.vibrationGain = pSurf->vibrationGain;
+		ps.vibrationLength = pSurf->vibrationLength;
+		ps.wavPitchSpeed = pSurf->wavPitchSpeed;
+		ps.isValidTrack = pSurf->isValidTrack;
+		ps.isPitlane = pSurf->isPitlane;
+		packSurfaces.push_back(ps);
+
+		vertices.insert(vertices.end(), trimesh->getVB(), trimesh->getVB() + ps.numVertices);
+		indices.insert(indices.end(), trimesh->getIB(), trimesh->getIB() + ps.numIndices);
+	}
+
+	TrackPackInfo info;
+	info.boundsMin = boundsMin;
+	info.boundsMax = boundsMax;
+	info.mergeSurfaces = mergeSurfaces ? 1 : 0;
+	info.closedLoop = closedLoop ? 1 : 0;
+	info.interpolateStep = interpolateStep;
+	info.splineSteps = interpolatedSpline ? interpolatedSpline->_steps : 0;
+	info.computedTrackWidth = computedTrackWidth;
+	info.computedTrackLength = computedTrackLength;
+
+	TrackPackWriter writer;
+	writer.add(TrackPackSectionId::Info, &info, 1);
+	writer.add(TrackPackSectionId::Surfaces, packSurfaces);
+	writer.add(TrackPackSectionId::Vertices, vertices);
+	writer.add(TrackPackSectionId::Indices, indices);
+	writer.add(TrackPackSectionId::BvhNodes, bvh.nodes);
+	writer.add(TrackPackSectionId::BvhTriangles, bvh.triangles);
+	writer.add(TrackPackSectionId::Pits, pits);
+	writer.add(TrackPackSectionId::SlimPoints, slimPoints);
+	writer.add(TrackPackSectionId::FatPoints, fatPoints);
+	writer.add(TrackPackSectionId::FatPointDistances, fatPointDistances);
+
+	if (interpolatedSpline)
+	{
+		writer.add(TrackPackSectionId::SplinePoints, interpolatedSpline->_points);
+		writer.add(TrackPackSectionId::SplineNodes, interpolatedSpline->_nodes);
+		writer.add(TrackPackSectionId::SplineDistances, interpolatedSpline->_distances);
+	}
+
+	if (useDistanceField && !distanceField.isValid())
+		initDistanceField();
+
+	if (useDistanceField && distanceField.isValid())
+	{
+		writer.add(TrackPackSectionId::DistanceFieldInfo, &distanceField.info, 1);
+		writer.add(TrackPackSectionId::DistanceFieldTiles, distanceField.tiles);
+		writer.add(TrackPackSectionId::DistanceFieldCells, distanceField.cells);
+	}
+
+	TrackPackHeader header;
+	header.sourceSurfacesHash = hashSourceFile(dataFolder + L"surfaces.bin");
+	header.sourceSplineHash = hashSourceFile(dataFolder + L"spline.bin");
+	header.configHash = computeTraceSettingsHash();
+
+	return writer.save(path.c_str(), header);
+}
+
 void Track::loadSurfaceBlob()
 {
-	colliders.clear();
+	meshes.clear();
+	surfaceMeshes.clear();
 	surfaces.clear();
+	bvh.clear();
 
 	FileHandle file;
 	auto strPath = dataFolder + L"surfaces.bin";
@@ -106,10 +626,13 @@ void Track::loadSurfaceBlob()
 	const bool fileValid = file.open(strPath.c_str(), L"rb");
 	GUARD_FATAL(fileValid);
 
+	boundsMin = vec3f(FLT_MAX, FLT_MAX, FLT_MAX);
+	boundsMax = vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
 	BlobSurface blob;
 	while (fread(&blob, sizeof(blob), 1, file.fd) == 1)
 	{
-		GUARD_FATAL(blob.magic == 0xAABBCCDD);
+		GUARD_FATAL(blob.magic == BLOB_SURFACE_MAGIC || blob.magic == BLOB_SURFACE_MAGIC_INDEX32);
 		GUARD_FATAL(blob.numVertices > 0 && blob.numIndices > 0);
 
 		if (!(blob.collisionCategory == C_CATEGORY_TRACK || blob.collisionCategory == C_CATEGORY_WALL))
@@ -120,7 +643,14 @@ void Track::loadSurfaceBlob()
 		auto trimesh = sim->physics->createTriMesh();
 		trimesh->resize(blob.numVertices, blob.numIndices);
 		GUARD_FATAL(fread(trimesh->getVB(), blob.numVertices * sizeof(TriMeshVertex), 1, file.fd) == 1);
-		GUARD_FATAL(fread(trimesh->getIB(), blob.numIndices * sizeof(TriMeshIndex), 1, file.fd) == 1);
+		GUARD_FATAL(readTriMeshIndices(file.fd, trimesh->getIB(), blob.numIndices, blob.magic == BLOB_SURFACE_MAGIC_INDEX32));
+
+		const auto* vb = trimesh->getVB();
+		for (size_t i = 0; i < blob.numVertices; ++i)
+		{
+			boundsMin = vec3f(tmin(boundsMin.x, vb[i].x), tmin(boundsMin.y, vb[i].y), tmin(boundsMin.z, vb[i].z));
+			boundsMax = vec3f(tmax(boundsMax.x, vb[i].x), tmax(boundsMax.y, vb[i].y), tmax(boundsMax.z, vb[i].z));
+		}
 
 		auto pSurf = std::make_shared<Surface>();
 		pSurf->trimesh = trimesh;
@@ -140,11 +670,116 @@ void Track::loadSurfaceBlob()
 
 		//log_printf(L"Surface: sectorID=%u collisionCategory=%u gripMod=%.3f damping=%.3f", pSurf->sectorID, pSurf->collisionCategory, pSurf->gripMod, pSurf->damping);
 
-		auto pCollider = sim->physics->createCollider(pSurf->trimesh, false, pSurf->sectorID, pSurf->collisionCategory, C_MASK_SURFACE);
-		pCollider->setUserPointer(pSurf.get());
-
 		surfaces.emplace_back(std::move(pSurf));
-		colliders.emplace_back(std::move(pCollider));
+	}
+
+	initSurfaceMeshes(useBVH != 0);
+}
+
+void Track::initSurfaceMeshes(bool buildBVH)
+{
+	std::vector<uint32_t> firstMeshTriangles;
+	if (mergeSurfaces)
+		createMergedMeshes(firstMeshTriangles);
+	else
+		createSurfaceMeshes(firstMeshTriangles);
+
+	log_printf(L"initSurfaceMeshes: surfaces=%d meshes=%d", (int)surfaces.size(), (int)meshes.size());
+
+	if (!surfaces.empty())
+		sim->physics->setWorldBounds(boundsMin, boundsMax);
+
+	if (buildBVH)
+	{
+		for (size_t i = 0; i < surfaces.size(); ++i)
+		{
+			auto* trimesh = surfaces[i]->trimesh.get();
+			bvh.addMesh(trimesh->getVB(), trimesh->getVertexCount(), trimesh->getIB(), trimesh->getIndexCount(), (uint32_t)i, firstMeshTriangles[i]);
+		}
+		bvh.build();
+	}
+}
+
+void Track::createSurfaceMeshes(std::vector<uint32_t>& firstMeshTriangles)
+{
+	firstMeshTriangles.assign(surfaces.size(), 0);
+
+	for (size_t i = 0; i < surfaces.size(); ++i)
+	{
+		auto* pSurf = surfaces[i].get();
+
+		auto mesh = std::make_unique<TrackMesh>();
+		mesh->surfaceIndex = (uint32_t)i;
+		mesh->collider = sim->physics->createCollider(pSurf->trimesh, false, pSurf->sectorID, pSurf->collisionCategory, C_MASK_SURFACE);
+		mesh->collider->setUserPointer(mesh.get());
+
+		surfaceMeshes.push_back((uint32_t)meshes.size());
+		meshes.emplace_back(std::move(mesh));
+	}
+}
+
+void Track::createMergedMeshes(std::vector<uint32_t>& firstMeshTriangles)
+{
+	// one mesh per collision category, split where vertex count exceeds TriMeshIndex range
+	const size_t maxVertices = (size_t)(TriMeshIndex)~(TriMeshIndex)0 + 1;
+
+	firstMeshTriangles.assign(surfaces.size(), 0);
+	surfaceMeshes.assign(surfaces.size(), 0);
+	std::vector<bool> merged(surfaces.size(), false);
+
+	for (size_t first = 0; first < surfaces.size(); ++first)
+	{
+		if (merged[first])
+			continue;
+
+		const uint32_t category = surfaces[first]->collisionCategory;
+		size_t next = first;
+
+		while (next < surfaces.size())
+		{
+			std::vector<TriMeshVertex> vertices;
+			std::vector<TriMeshIndex> indices;
+			auto mesh = std::make_unique<TrackMesh>();
+
+			for (; next < surfaces.size(); ++next)
+			{
+				auto* pSurf = surfaces[next].get();
+				if (merged[next] || pSurf->collisionCategory != category)
+					continue;
+
+				auto* src = pSurf->trimesh.get();
+				const size_t numVertices = src->getVertexCount();
+				const size_t numIndices = src->getIndexCount();
+				GUARD_FATAL(numVertices <= maxVertices);
+
+				if (vertices.size() + numVertices > maxVertices)
+					break;
+
+				const size_t baseVertex = vertices.size();
+				firstMeshTriangles[next] = (uint32_t)(indices.size() / 3);
+				surfaceMeshes[next] = (uint32_t)meshes.size();
+				merged[next] = true;
+
+				vertices.insert(vertices.end(), src->getVB(), src->getVB() + numVertices);
+				for (size_t i = 0; i < numIndices; ++i)
+					indices.push_back((TriMeshIndex)(baseVertex + src->getIB()[i]));
+				mesh->triangleSurfaces.insert(mesh->triangleSurfaces.end(), numIndices / 3, (uint32_t)next);
+			}
+
+			if (indices.empty())
+				break;
+
+			auto trimesh = sim->physics->createTriMesh();
+			trimesh->resize(vertices.size(), indices.size());
+			memcpy(trimesh->getVB(), vertices.data(), vertices.size() * sizeof(TriMeshVertex));
+			memcpy(trimesh->getIB(), indices.data(), indices.size() * sizeof(TriMeshIndex));
+
+			mesh->surfaceIndex = mesh->triangleSurfaces.front();
+			mesh->trimesh = trimesh;
+			mesh->collider = sim->physics->createCollider(trimesh, false, 0, category, C_MASK_SURFACE);
+			mesh->collider->setUserPointer(mesh.get());
+			meshes.emplace_back(std::move(mesh));
+		}
 	}
 }
 
@@ -175,7 +810,7 @@ void Track::loadPits()
 	}
 }
 
-void Track::initTrackPoints()
+bool Track::loadSplineConfig()
 {
 	traceBadSectors.clear();
 
@@ -203,6 +838,12 @@ void Track::initTrackPoints()
 		}
 	}
 
+	return ini->ready;
+}
+
+void Track::initTrackPoints()
+{
+	loadSplineConfig();
 	loadSlimPoints();
 	loadFatPoints();
 
@@ -213,31 +854,25 @@ void Track::initTrackPoints()
 
 	if (fatPoints.empty() && !slimPoints.empty())
 	{
-		computeFatPoints();
-		saveFatPoints();
+		if (computeFatPoints())
+			saveFatPoints();
 	}
 
 	interpolatedSpline.reset();
+	arcSpline.clear();
+	profile.clear();
 	fatPointDistances.clear();
-	nearbyPoints.clear();
+	fatPointsGrid = UniformGrid();
+	boundsSegments.clear();
+	distanceField.clear();
 
-	pointCachePos = vec3f(0, -10000, 0);
 	computedTrackWidth = 0.1f;
 	computedTrackLength = 0.1f;
 
 	if (!fatPoints.empty())
 	{
-		float cellSize = 50;
-		int tableSize = 4096;
-
-		auto simIni(std::make_unique<INIReader>(sim->basePath + L"cfg/sim.ini"));
-		if (simIni->ready)
-		{
-			simIni->tryGetFloat(L"VERTEX_HASH", L"CELL_SIZE", cellSize);
-			simIni->tryGetInt(L"VERTEX_HASH", L"TABLE_SIZE", tableSize);
-		}
-
-		fatPointsHash.init(cellSize, (size_t)tableSize); // allows to query points around specific location
+		initFatPointsGrid();
+		initBoundsSegments();
 
 		const size_t numPoints = fatPoints.size();
 
@@ -249,7 +884,6 @@ void Track::initTrackPoints()
 		for (size_t id = 0; id < numPoints; ++id)
 		{
 			splinePoints[id] = fatPoints[id].TRACK_MIDPOINT;
-			fatPointsHash.add(fatPoints[id].TRACK_MIDPOINT, id);
 
 			const float width = (fatPoints[id].left - fatPoints[id].right).len();
 			if (computedTrackWidth < width)
@@ -268,9 +902,41 @@ void Track::initTrackPoints()
 		interpolatedSpline->set_steps(interpolateStep);
 		interpolatedSpline->init_from_array(splinePoints, closedLoop);
 		computedTrackLength = interpolatedSpline->total_length();
+		initArcSpline();
+		initProfile();
+
+		if (useDistanceField)
+			initDistanceField();
 	}
 }
 
+void Track::initArcSpline()
+{
+	arcSpline.clear();
+
+	// arc length parameterized copy for incremental projection of car positions
+	if (interpolatedSpline && !interpolatedSpline->is_empty())
+		arcSpline.init_from_spline(*interpolatedSpline, arcSplineStep);
+}
+
+void Track::initFatPointsGrid()
+{
+	float cellSize = 50;
+
+	auto simIni(std::make_unique<INIReader>(sim->basePath + L"cfg/sim.ini"));
+	if (simIni->ready)
+	{
+		simIni->tryGetFloat(L"VERTEX_HASH", L"CELL_SIZE", cellSize);
+	}
+
+	// allows to query points around specific location
+	std::vector<vec3f> points(fatPoints.size());
+	for (size_t id = 0; id < fatPoints.size(); ++id)
+		points[id] = fatPoints[id].TRACK_MIDPOINT;
+
+	fatPointsGrid.build(points.data(), points.size(), cellSize);
+}
+
 void Track::loadSlimPoints()
 {
 	slimPoints.clear();
@@ -363,72 +1029,222 @@ void Track::saveSenseiPoints(const std::wstring& modelName)
 	}
 }
 
-void Track::computeFatPoints()
+bool Track::computeFatPoints()
 {
 	fatPoints.clear();
 
 	const auto numPoints = slimPoints.size();
 	if (!numPoints)
-		return;
+		return true;
 
 	fatPoints.resize(numPoints);
 	memset(fatPoints.data(), 0, sizeof(fatPoints[0]) * numPoints);
 
+	std::vector<uint8_t> done(numPoints, 0);
+	if (loadFatPointsCheckpoint(done))
+		log_printf(L"computeFatPoints: resumed at %d/%d", (int)std::count(done.begin(), done.end(), 1), (int)numPoints);
+
+	std::vector<size_t> pending;
+	for (size_t i = 0; i < numPoints; ++i)
+	{
+		if (!done[i])
+			pending.push_back(i);
+	}
+
+	// BVH ray casts are read-only, ODE fallback shares one ray and space
+	std::unique_ptr<ThreadPool> pool;
+	if (bvh.isValid() && traceThreads != 1)
+		pool.reset(new ThreadPool(traceThreads));
+
+	log_printf(L"computeFatPoints: numPoints=%d pending=%d traceSides=%d threads=%d",
+		(int)numPoints, (int)pending.size(), (int)traceSides, pool ? pool->getThreadCount() : 1);
+
+	const size_t chunkSize = traceSides ? 256 : 4096;
+	const unsigned int startTicks = osGetCurrentTicks();
+	unsigned int checkpointTicks = startTicks;
+	size_t numDone = numPoints - pending.size();
+	size_t next = 0;
+
+	while (next < pending.size())
+	{
+		const size_t n = tmin(pending.size() - next, chunkSize);
+		const size_t* ids = pending.data() + next;
+
+		if (pool)
+		{
+			pool->parallelFor(n, [this, ids](size_t i) { computeFatPoint(ids[i], traceSides); });
+		}
+		else
+		{
+			for (size_t i = 0; i < n; ++i)
+				computeFatPoint(ids[i], traceSides);
+		}
+
+		for (size_t i = 0; i < n; ++i)
+			done[ids[i]] = 1;
+
+		next += n;
+		numDone += n;
+
+		const unsigned int ticks = osGetCurrentTicks();
+		log_printf(L"computeFatPoints: %d/%d (%.1f%%)", (int)numDone, (int)numPoints, (float)numDone * 100.0f / (float)numPoints);
+
+		if (next < pending.size())
+		{
+			if (traceCheckpointSeconds > 0 && (float)(ticks - checkpointTicks) * 0.001f >= traceCheckpointSeconds)
+			{
+				saveFatPointsCheckpoint(done);
+				checkpointTicks = ticks;
+			}
+
+			if (traceTimeBudget > 0 && (float)(ticks - startTicks) * 0.001f >= traceTimeBudget)
+				break;
+		}
+	}
+
+	if (next < pending.size())
+	{
+		saveFatPointsCheckpoint(done);
+		log_printf(L"computeFatPoints: time budget exceeded, %d points use untraced sides until next load", (int)(pending.size() - next));
+
+		for (size_t i = next; i < pending.size(); ++i)
+			computeFatPoint(pending[i], false);
+		return false;
+	}
+
+	std::remove(stra(dataFolder + L"spline.cache.partial").c_str());
+	log_printf(L"computeFatPoints: DONE in %.1f s", (float)(osGetCurrentTicks() - startTicks) * 0.001f);
+	return true;
+}
+
+void Track::computeFatPoint(size_t i, bool traceSidesFlag)
+{
+	const auto numPoints = slimPoints.size();
 	const vec3f rayOff(0, traceRayOffsetY, 0);
 	const int numTraceSteps = (int)(traceSideMax / traceStep);
 
 	TrackRayCastHit hit;
 
-	for (size_t i = 0; i < numPoints; ++i)
-	{
-		const auto& slim = slimPoints[i];
-		auto& fat = fatPoints[i];
+	const auto& slim = slimPoints[i];
+	auto& fat = fatPoints[i];
 
-		const auto& rayStart = slim.best + rayOff;
+	const auto& rayStart = slim.best + rayOff;
 
-		if (rayCast(rayStart, vec3f(0, -1, 0), traceRayLength, hit))
-		{
-			const auto roadCategory = hit.surface->collisionCategory;
-			fat.best = hit.pos;
+	if (rayCast(rayStart, vec3f(0, -1, 0), traceRayLength, hit))
+	{
+		fat.best = hit.pos;
 
-			const float baseGrip = hit.surface->gripMod;
+		/*auto nextI = i + 1;
+		if (nextI >= numPoints)
+			nextI = 0;
+		fat.forwardDir = (slimPoints[nextI].best - slim.best).get_norm();*/
 
-			/*auto nextI = i + 1;
-			if (nextI >= numPoints)
-				nextI = 0;
-			fat.forwardDir = (slimPoints[nextI].best - slim.best).get_norm();*/
+		if (i + 1 < numPoints)
+			fat.forwardDir = (slimPoints[i + 1].best - slim.best).get_norm();
+		else if (i > 0)
+			fat.forwardDir = (slim.best - slimPoints[i - 1].best).get_norm();
 
-			if (i + 1 < numPoints)
-				fat.forwardDir = (slimPoints[i + 1].best - slim.best).get_norm();
-			else if (i > 0)
-				fat.forwardDir = (slim.best - slimPoints[i - 1].best).get_norm();
+		auto leftDir = fat.forwardDir.cross(vec3f(0, -1, 0)).get_norm();
+		auto rightDir = leftDir * -1.0f;
 
-			auto leftDir = fat.forwardDir.cross(vec3f(0, -1, 0)).get_norm();
-			auto rightDir = leftDir * -1.0f;
+		if (!traceSidesFlag)
+		{
+			fat.left = fat.best + leftDir * slimPoints[i].sides[0];
+			fat.right = fat.best + rightDir * slimPoints[i].sides[1];
 
-			if (!traceSides)
+			if (rayCast(fat.left + rayOff, vec3f(0, -1, 0), traceRayLength, hit))
 			{
-				fat.left = fat.best + leftDir * slimPoints[i].sides[0];
-				fat.right = fat.best + rightDir * slimPoints[i].sides[1];
-
-				if (rayCast(fat.left + rayOff, vec3f(0, -1, 0), traceRayLength, hit))
-				{
-					fat.left = hit.pos;
-				}
-
-				if (rayCast(fat.right + rayOff, vec3f(0, -1, 0), traceRayLength, hit))
-				{
-					fat.right = hit.pos;
-				}
+				fat.left = hit.pos;
 			}
-			else // ray trace sides (slow)
+
+			if (rayCast(fat.right + rayOff, vec3f(0, -1, 0), traceRayLength, hit))
 			{
-				fat.left = computeSideLocation(slim, fat, hit, rayStart, leftDir, numTraceSteps);
-				fat.right = computeSideLocation(slim, fat, hit, rayStart, rightDir, numTraceSteps);
+				fat.right = hit.pos;
 			}
-
-			fat.center = (fat.left + fat.right) * 0.5f;
 		}
+		else // ray trace sides (slow)
+		{
+			fat.left = computeSideLocation(slim, fat, hit, rayStart, leftDir, numTraceSteps);
+			fat.right = computeSideLocation(slim, fat, hit, rayStart, rightDir, numTraceSteps);
+		}
+
+		fat.center = (fat.left + fat.right) * 0.5f;
+	}
+}
+
+struct FatPointsCheckpointHeader
+{
+	static const uint32_t Magic = 0x43504650; // PFPC
+
+	uint32_t magic = 0;
+	uint32_t numPoints = 0;
+	uint64_t configHash = 0;
+};
+
+uint64_t Track::computeTraceSettingsHash() const
+{
+	const float params[] = {traceRayOffsetY, traceRayLength, traceSideMax, traceDiffHeightMax, traceDiffGripMax, traceStep};
+	const uint8_t flags[] = {(uint8_t)traceSides, (uint8_t)closedLoop};
+
+	uint64_t h = hashStateBytes(params, sizeof(params));
+	h = hashStateBytes(flags, sizeof(flags), h);
+
+	std::vector<int> badSectors(traceBadSectors.begin(), traceBadSectors.end());
+	std::sort(badSectors.begin(), badSectors.end());
+	return hashStateBytes(badSectors.data(), badSectors.size() * sizeof(int), h);
+}
+
+uint64_t Track::computeTraceConfigHash() const
+{
+	// everything the traced result depends on
+	return hashStateBytes(slimPoints.data(), slimPoints.size() * sizeof(slimPoints[0]), computeTraceSettingsHash());
+}
+
+bool Track::loadFatPointsCheckpoint(std::vector<uint8_t>& done)
+{
+	FileHandle file;
+	auto strPath = dataFolder + L"spline.cache.partial";
+	if (!file.open(strPath.c_str(), L"rb"))
+		return false;
+
+	const size_t numPoints = fatPoints.size();
+
+	FatPointsCheckpointHeader header;
+	if (fread(&header, sizeof(header), 1, file.fd) != 1
+		|| header.magic != FatPointsCheckpointHeader::Magic
+		|| header.numPoints != (uint32_t)numPoints
+		|| header.configHash != computeTraceConfigHash())
+	{
+		log_printf(L"loadFatPointsCheckpoint: %s does not match, ignored", strPath.c_str());
+		return false;
+	}
+
+	std::vector<uint8_t> fileDone(numPoints);
+	std::vector<FatTrackPoint> filePoints(numPoints);
+	if (fread(fileDone.data(), numPoints, 1, file.fd) != 1 || fread(filePoints.data(), sizeof(FatTrackPoint) * numPoints, 1, file.fd) != 1)
+		return false;
+
+	done.swap(fileDone);
+	fatPoints.swap(filePoints);
+	return true;
+}
+
+void Track::saveFatPointsCheckpoint(const std::vector<uint8_t>& done)
+{
+	FileHandle file;
+	auto strPath = dataFolder + L"spline.cache.partial";
+	log_printf(L"saveFatPointsCheckpoint: %s", strPath.c_str());
+
+	if (file.open(strPath.c_str(), L"wb"))
+	{
+		FatPointsCheckpointHeader header;
+		header.magic = FatPointsCheckpointHeader::Magic;
+		header.numPoints = (uint32_t)fatPoints.size();
+		header.configHash = computeTraceConfigHash();
+
+		fwrite(&header, sizeof(header), 1, file.fd);
+		fwrite(done.data(), done.size(), 1, file.fd);
+		fwrite(fatPoints.data(), sizeof(fatPoints[0]) * fatPoints.size(), 1, file.fd);
 	}
 }
 
@@ -466,101 +1282,317 @@ vec3f Track::computeSideLocation(const SlimTrackPoint& slim, FatTrackPoint& fat,
 	return result;
 }
 
-inline bool getLineIntersection(float p0_x, float p0_y, float p1_x, float p1_y, float p2_x, float p2_y, float p3_x, float p3_y, float &i_x, float &i_y)
+void Track::initProfile()
 {
-	// https://stackoverflow.com/questions/563198/how-do-you-detect-where-two-line-sp-intersect
+	profile.clear();
 
-	float s1_x, s1_y, s2_x, s2_y;
-	s1_x = p1_x - p0_x; s1_y = p1_y - p0_y;
-	s2_x = p3_x - p2_x; s2_y = p3_y - p2_y;
+	const int numSamples = (int)arcSpline._knots.size();
+	const size_t numPoints = fatPoints.size();
+	if (arcSpline.is_empty() || !numPoints)
+		return;
 
-	float s, t;
-	s = (-s1_y * (p0_x - p2_x) + s1_x * (p0_y - p2_y)) / (-s2_x * s1_y + s1_x * s2_y);
-	t = (s2_x * (p0_y - p2_y) - s2_y * (p0_x - p2_x)) / (-s2_x * s1_y + s1_x * s2_y);
+	profile.init(arcSpline.total_length(), arcSpline._step, arcSpline._closed_loop);
+	profile.samples.resize(numSamples);
 
-	if (s >= 0 && s <= 1 && t >= 0 && t <= 1)
+	size_t pointId = getPointIdAtLocation(arcSpline._knots[0]);
+	float grip = 1.0f;
+
+	for (int k = 0; k < numSamples; ++k)
 	{
-		i_x = p0_x + (t * s1_x);
-		i_y = p0_y + (t * s1_y);
-		return true;
+		const auto& pos = arcSpline._knots[k];
+		const auto& dir = arcSpline._tangents[k];
+		auto& s = profile.samples[k];
+
+		s.heading = atan2f(dir.x, dir.z);
+		s.elevation = pos.y;
+
+		// sides blended between nearest fat point and the neighbour on the side of the sample
+		pointId = getPointIdNear(pos, pointId);
+		const auto& p0 = fatPoints[pointId];
+		const bool ahead = (pos - p0.TRACK_MIDPOINT) * p0.forwardDir >= 0.0f;
+		size_t otherId = pointId;
+		if (ahead)
+			otherId = (pointId + 1 < numPoints) ? pointId + 1 : (closedLoop ? 0 : pointId);
+		else
+			otherId = (pointId > 0) ? pointId - 1 : (closedLoop ? numPoints - 1 : pointId);
+
+		const auto& p1 = fatPoints[otherId];
+		const float span = (p1.TRACK_MIDPOINT - p0.TRACK_MIDPOINT).len();
+		const float u = (span > 0.0f) ? tclamp((pos - p0.TRACK_MIDPOINT).len() / span, 0.0f, 1.0f) : 0.0f;
+
+		const vec3f left = p0.left + (p1.left - p0.left) * u;
+		const vec3f right = p0.right + (p1.right - p0.right) * u;
+		s.width = (left - right).len();
+		s.banking = (s.width > 0.0f) ? asinf(tclamp((left.y - right.y) / s.width, -1.0f, 1.0f)) : 0.0f;
+
+		// keep previous grip over holes
+		TrackRayCastHit hit;
+		if (rayCast(pos + vec3f(0, 2.0f, 0), vec3f(0, -1, 0), 10.0f, hit) && hit.surface)
+			grip = hit.surface->gripMod;
+		s.grip = grip;
 	}
 
-	return false;
+	for (int k = 0; k < numSamples; ++k)
+	{
+		int k0 = k - 1, k1 = k + 1;
+		if (profile.closedLoop)
+		{
+			if (k0 < 0) k0 = numSamples - 1;
+			if (k1 >= numSamples) k1 = 0;
+		}
+		else
+		{
+			k0 = tmax(k0, 0);
+			k1 = tmin(k1, numSamples - 1);
+		}
+
+		const float ds = (float)(k1 - k0 == 1 ? 1 : 2) * profile.step;
+		profile.samples[k].curvature = wrapAngle(profile.samples[k1].heading - profile.samples[k0].heading) / ds;
+	}
 }
 
-inline bool getLineIntersection(const vec2f& p0, const vec2f& p1, const vec2f& p2, const vec2f& p3, vec2f& i)
+void Track::initBoundsSegments()
 {
-	return getLineIntersection(p0.x, p0.y, p1.x, p1.y, p2.x, p2.y, p3.x, p3.y, i.x, i.y);
+	const size_t numPoints = fatPoints.size();
+	boundsSegments.resize(numPoints * 2);
+
+	for (size_t id = 0; id < numPoints; ++id)
+	{
+		// open tracks: last point has no segment back to 0, zero extent never hits
+		const size_t other = id + 1 < numPoints ? id + 1 : (closedLoop ? 0 : id);
+
+		for (int side = 0; side < 2; ++side)
+		{
+			const vec3f& sideA = side ? fatPoints[id].right : fatPoints[id].left;
+			const vec3f& sideB = side ? fatPoints[other].right : fatPoints[other].left;
+
+			auto& seg = boundsSegments[id * 2 + side];
+			seg.x = sideA.x;
+			seg.y = sideA.z;
+			seg.z = sideB.x - sideA.x;
+			seg.w = sideB.z - sideA.z;
+		}
+	}
 }
 
-// many tracks don't have guardrails/walls, fake them by tracing against track side splines
-float Track::rayCastTrackBounds(const vec3f& pos, const vec3f& dir, float maxDistance)
+void Track::initDistanceField()
 {
-	if (maxDistance <= 0.0f)
-		maxDistance = fatPointsHash.cellSize;
+	// fat points are indexed by midpoint, their sides are up to track width and one segment away
+	if (fatPoints.size() < 2)
+		return;
 
-	float result = maxDistance;
+	// open tracks skip the wrap segment (last point back to 0)
+	const size_t numSegments = (closedLoop ? fatPoints.size() : fatPoints.size() - 1) * 2;
+	float maxSegmentLength = 0;
+	for (size_t i = 0; i < numSegments; ++i)
+	{
+		const auto& seg = boundsSegments[i];
+		maxSegmentLength = tmax(maxSegmentLength, sqrtf(seg.z * seg.z + seg.w * seg.w));
+	}
+
+	distanceField.bake(boundsSegments.data(), fatPoints.size(), closedLoop, fatPointsGrid, computedTrackWidth + maxSegmentLength,
+		distanceFieldCellSize, distanceFieldMaxDistance, traceThreads);
+}
 
+void Track::updatePointCache(TrackPointCache& cache, const vec3f& pos, float radius) const
+{
 	// allow points to be cached by query position
 	const float cacheDistanceTolerance = 1.0f;
-	if ((pointCachePos - pos).sqlen() > cacheDistanceTolerance * cacheDistanceTolerance)
+	if ((cache.pos - pos).sqlen() > cacheDistanceTolerance * cacheDistanceTolerance || cache.radius != radius)
 	{
-		pointCachePos = pos;
-		nearbyPoints.clear();
-		fatPointsHash.queryNeighbours(pos, nearbyPoints, maxDistance);
+		cache.pos = pos;
+		cache.radius = radius;
+		fatPointsGrid.query(pos, radius, cache.points);
+		initPointCacheSegments(cache);
 	}
+}
+
+void Track::initPointCacheSegments(TrackPointCache& cache) const
+{
+	const uint32_t numSegments = (uint32_t)cache.points.size() * 2;
+	const uint32_t stride = (numSegments + 7) & ~7u;
+
+	cache.segmentStride = stride;
+	cache.segments.assign((size_t)stride * 4, 0.0f);
 
-	if (!nearbyPoints.empty())
+	float* ax = cache.segments.data();
+	float* az = ax + stride;
+	float* ex = az + stride;
+	float* ez = ex + stride;
+
+	// same segments as the distance field, open tracks skip the last point (zero filled like padding)
+	const uint32_t skipId = closedLoop ? UINT32_MAX : (uint32_t)fatPoints.size() - 1;
+
+	uint32_t n = 0;
+	for (uint32_t id : cache.points)
 	{
-		const auto rayEnd = pos + dir * (maxDistance * 1.1f); // make ray a little longer then point cutoff distance
+		if (id == skipId)
+			continue;
 
-		const auto rayA = vec2f(pos.x, pos.z);
-		const auto rayB = vec2f(rayEnd.x, rayEnd.z);
+		for (int side = 0; side < 2; ++side, ++n)
+		{
+			const auto& seg = boundsSegments[id * 2 + side];
+			ax[n] = seg.x;
+			az[n] = seg.y;
+			ex[n] = seg.z;
+			ez[n] = seg.w;
+		}
+	}
+}
 
-		vec2f inter(0, 0);
-		float bestDist = FLT_MAX;
-		bool interFlag = false;
+// https://stackoverflow.com/questions/563198/how-do-you-detect-where-two-line-segments-intersect
+// ray p0 + t * s1 hits side p2 + s * s2 when both parameters are in [0, 1], same arithmetic as AVX kernel
+inline bool getLineIntersection(float p0_x, float p0_y, float s1_x, float s1_y, float p2_x, float p2_y, float s2_x, float s2_y, float& t)
+{
+	const float dx = p0_x - p2_x, dy = p0_y - p2_y;
+	const float den = s1_x * s2_y - s2_x * s1_y;
+	const float s = (s1_x * dy - s1_y * dx) / den;
+	t = (s2_x * dy - s2_y * dx) / den;
+	return (s >= 0 && s <= 1 && t >= 0 && t <= 1);
+}
 
-		const size_t maxPoints = fatPoints.size();
+static void rayCastBoundsScalar(const TrackPointCache& cache, const ray3f* rays, size_t count, float* hits)
+{
+	const uint32_t stride = cache.segmentStride;
+	const uint32_t numSegments = (uint32_t)cache.points.size() * 2;
+	const float* ax = cache.segments.data();
+	const float* az = ax + stride;
+	const float* ex = az + stride;
+	const float* ez = ex + stride;
+
+	for (size_t r = 0; r < count; ++r)
+	{
+		const auto& ray = rays[r];
+		const auto rayEnd = ray.pos + ray.dir * (ray.length * 1.1f); // make ray a little longer then point cutoff distance
+		const vec2f s1(rayEnd.x - ray.pos.x, rayEnd.z - ray.pos.z);
 
-		for (size_t id : nearbyPoints)
+		float bestT = FLT_MAX;
+		for (uint32_t i = 0; i < numSegments; ++i)
 		{
-			const size_t other = id + 1 < maxPoints ? id + 1 : 0;
+			float t;
+			if (getLineIntersection(ray.pos.x, ray.pos.z, s1.x, s1.y, ax[i], az[i], ex[i], ez[i], t))
+				bestT = tmin(bestT, t);
+		}
 
-			auto sideA = fatPoints[id].left;
-			auto sideB = fatPoints[other].left;
+		hits[r] = (bestT < FLT_MAX) ? bestT * s1.len() : ray.length;
+	}
+}
 
-			if (getLineIntersection(rayA, rayB, vec2f(sideA.x, sideA.z), vec2f(sideB.x, sideB.z), inter))
-			{
-				bestDist = tmin(bestDist, (rayA - inter).len());
-				interFlag = true;
+// every ray of the batch against 8 cached side segments at a time
+static D_TARGET_AVX2 void rayCastBoundsAVX(const TrackPointCache& cache, const ray3f* rays, size_t count, float* hits)
+{
+	const int PacketSize = 8;
+	const uint32_t stride = cache.segmentStride;
+	const float* segments = cache.segments.data();
 
-				#if (TRACK_DEBUG_DRAW)
-				DebugGL::get().line(sideA, sideB, vec3f(1, 0, 0));
-				#endif
-			}
+	for (size_t first = 0; first < count; first += PacketSize)
+	{
+		const int n = (int)tmin(count - first, (size_t)PacketSize);
+
+		// 2D segment intersection: ray p0 + t * s1, side p2 + s * s2, hit when both parameters are in [0, 1]
+		__m256 p0x[PacketSize], p0y[PacketSize], s1x[PacketSize], s1y[PacketSize], bestT[PacketSize];
+		float rayLen[PacketSize];
+
+		for (int r = 0; r < n; ++r)
+		{
+			const auto& ray = rays[first + r];
+			const auto rayEnd = ray.pos + ray.dir * (ray.length * 1.1f); // make ray a little longer then point cutoff distance
+			const vec2f s1(rayEnd.x - ray.pos.x, rayEnd.z - ray.pos.z);
+
+			p0x[r] = _mm256_set1_ps(ray.pos.x);
+			p0y[r] = _mm256_set1_ps(ray.pos.z);
+			s1x[r] = _mm256_set1_ps(s1.x);
+			s1y[r] = _mm256_set1_ps(s1.y);
+			bestT[r] = _mm256_set1_ps(FLT_MAX);
+			rayLen[r] = s1.len();
+		}
+
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
 
-			sideA = fatPoints[id].right;
-			sideB = fatPoints[other].right;
+		// padding segments have zero extent, their parameters are inf/nan and fail the range test
+		for (uint32_t i = 0; i < stride; i += 8)
+		{
+			const __m256 ax = _mm256_loadu_ps(segments + i);
+			const __m256 az = _mm256_loadu_ps(segments + stride + i);
+			const __m256 ex = _mm256_loadu_ps(segments + stride * 2 + i);
+			const __m256 ez = _mm256_loadu_ps(segments + stride * 3 + i);
 
-			if (getLineIntersection(rayA, rayB, vec2f(sideA.x, sideA.z), vec2f(sideB.x, sideB.z), inter))
+			for (int r = 0; r < n; ++r)
 			{
-				bestDist = tmin(bestDist, (rayA - inter).len());
-				interFlag = true;
+				const __m256 dx = _mm256_sub_ps(p0x[r], ax);
+				const __m256 dy = _mm256_sub_ps(p0y[r], az);
+				const __m256 den = _mm256_sub_ps(_mm256_mul_ps(s1x[r], ez), _mm256_mul_ps(ex, s1y[r]));
+				const __m256 s = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(s1x[r], dy), _mm256_mul_ps(s1y[r], dx)), den);
+				const __m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(ex, dy), _mm256_mul_ps(ez, dx)), den);
 
-				#if (TRACK_DEBUG_DRAW)
-				DebugGL::get().line(sideA, sideB, vec3f(1, 0, 0));
-				#endif
+				const __m256 m = _mm256_and_ps(
+					_mm256_and_ps(_mm256_cmp_ps(s, zero, _CMP_GE_OQ), _mm256_cmp_ps(s, one, _CMP_LE_OQ)),
+					_mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, one, _CMP_LE_OQ)));
+
+				bestT[r] = _mm256_min_ps(bestT[r], _mm256_blendv_ps(_mm256_set1_ps(FLT_MAX), t, m));
 			}
 		}
 
-		if (interFlag)
-			result = bestDist;
+		for (int r = 0; r < n; ++r)
+		{
+			alignas(32) float lanes[8];
+			_mm256_store_ps(lanes, bestT[r]);
+
+			float t = lanes[0];
+			for (int i = 1; i < 8; ++i)
+				t = tmin(t, lanes[i]);
+
+			hits[first + r] = (t < FLT_MAX) ? t * rayLen[r] : rays[first + r].length;
+		}
 	}
+}
+
+// many tracks don't have guardrails/walls, fake them by tracing against track side splines
+float Track::rayCastTrackBounds(TrackPointCache& cache, const vec3f& pos, const vec3f& dir, float maxDistance) const
+{
+	if (maxDistance <= 0.0f)
+		maxDistance = fatPointsGrid.cellSize;
+
+	const ray3f ray(pos, dir, maxDistance);
+	float result = maxDistance;
+	rayCastTrackBounds(cache, &ray, 1, &result);
 
 	return result;
 }
 
+void Track::rayCastTrackBounds(TrackPointCache& cache, const ray3f* rays, size_t count, float* hits) const
+{
+	if (!count)
+		return;
+
+	if (useDistanceField && distanceField.isValid())
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto& ray = rays[i];
+			const float lengthXZ = ray.length * 1.1f * sqrtf(ray.dir.x * ray.dir.x + ray.dir.z * ray.dir.z); // same reach as segment test
+			const vec2f dirXZ = vec2f(ray.dir.x, ray.dir.z).get_norm();
+
+			float t = 0;
+			hits[i] = (lengthXZ > 0.0f && distanceField.trace(ray.pos.x, ray.pos.z, dirXZ.x, dirXZ.y, lengthXZ, t)) ? t : ray.length;
+		}
+		return;
+	}
+
+	// one point query around first ray covers all of them
+	float radius = 0;
+	for (size_t i = 0; i < count; ++i)
+		radius = tmax(radius, (rays[i].pos - rays[0].pos).len() + rays[i].length);
+
+	updatePointCache(cache, rays[0].pos, radius);
+
+	if (cpuHasAvx2())
+		rayCastBoundsAVX(cache, rays, count, hits);
+	else
+		rayCastBoundsScalar(cache, rays, count, hits);
+}
+
 size_t Track::getPointIdAtDistance(float distanceNorm) const
 {
 	const size_t numPoints = fatPoints.size();
@@ -579,22 +1611,113 @@ size_t Track::getPointIdAtDistance(float distanceNorm) const
 size_t Track::getPointIdAtLocation(const vec3f& pos) const
 {
 	float bestDistSq = FLT_MAX;
-	int bestPoint = 0;
+	size_t bestPoint = 0;
+
+	std::vector<uint32_t> points;
+	fatPointsGrid.query(pos, 0.0f, points);
 
-	for (const auto& pointId : nearbyPoints)
+	if (!points.empty())
 	{
-		const auto pointPos = fatPoints[pointId].TRACK_MIDPOINT;
-		const auto distSq = (pointPos - pos).sqlen();
-		if (bestDistSq > distSq)
+		for (const auto& pointId : points)
 		{
-			bestDistSq = distSq;
-			bestPoint = (int)pointId;
+			const auto distSq = (fatPoints[pointId].TRACK_MIDPOINT - pos).sqlen();
+			if (bestDistSq > distSq)
+			{
+				bestDistSq = distSq;
+				bestPoint = pointId;
+			}
+		}
+	}
+	else
+	{
+		// far from track
+		for (size_t pointId = 0; pointId < fatPoints.size(); ++pointId)
+		{
+			const auto distSq = (fatPoints[pointId].TRACK_MIDPOINT - pos).sqlen();
+			if (bestDistSq > distSq)
+			{
+				bestDistSq = distSq;
+				bestPoint = pointId;
+			}
 		}
 	}
 
 	return bestPoint;
 }
 
+size_t Track::getPointIdNear(const vec3f& pos, size_t pointId) const
+{
+	const size_t numPoints = fatPoints.size();
+	if (pointId >= numPoints)
+		return getPointIdAtLocation(pos);
+
+	// descend along the track from previous nearest point
+	float bestDistSq = (fatPoints[pointId].TRACK_MIDPOINT - pos).sqlen();
+	for (size_t iter = 0; iter < numPoints; ++iter)
+	{
+		const size_t prevId = (pointId > 0) ? pointId - 1 : (closedLoop ? numPoints - 1 : pointId);
+		const size_t nextId = (pointId + 1 < numPoints) ? pointId + 1 : (closedLoop ? 0 : pointId);
+
+		const float prevDistSq = (fatPoints[prevId].TRACK_MIDPOINT - pos).sqlen();
+		const float nextDistSq = (fatPoints[nextId].TRACK_MIDPOINT - pos).sqlen();
+
+		if (prevDistSq < bestDistSq && prevDistSq <= nextDistSq)
+		{
+			bestDistSq = prevDistSq;
+			pointId = prevId;
+		}
+		else if (nextDistSq < bestDistSq)
+		{
+			bestDistSq = nextDistSq;
+			pointId = nextId;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return pointId;
+}
+
+bool Track::updateLocator(TrackLocator& loc, const vec3f& pos) const
+{
+	const int numPoints = (int)fatPoints.size();
+	if (numPoints < 5 || arcSpline.is_empty())
+	{
+		loc.valid = 0;
+		return false;
+	}
+
+	if (loc.valid && ((loc.pos - pos).sqlen() > locatorResetDistance * locatorResetDistance || loc.pointId < 0 || loc.pointId >= numPoints))
+		loc.valid = 0;
+
+	if (loc.valid)
+	{
+		loc.pointId = (int)getPointIdNear(pos, (size_t)loc.pointId);
+	}
+	else
+	{
+		// first update or teleport
+		loc.pointId = (int)getPointIdAtLocation(pos);
+
+		Spline3dPointInfo info;
+		if (!getDistanceAlongSplineAtLocation(pos, loc.pointId, info))
+			return false;
+
+		loc.distance = info.dist;
+		loc.nodeId = info.id;
+	}
+
+	loc.distance = arcSpline.project(pos, loc.distance);
+	loc.nodeId = interpolatedSpline->node_at_length(loc.distance, loc.nodeId);
+	arcSpline.eval(loc.distance, &loc.splinePos);
+	loc.pos = pos;
+	loc.valid = 1;
+
+	return true;
+}
+
 vec3f Track::getTrackDirectionAtDistance(float distanceNorm) const
 {
 	const size_t pointId = getPointIdAtDistance(distanceNorm);
@@ -698,4 +1821,9 @@ bool Track::getDistanceAlongSplineAtLocation(const vec3f& pos, int pointId, Spli
 	return true;
 }
 
+void Track::serializeState(StateArchive& ar)
+{
+	ar.io(dynamicGripLevel);
+}
+
 }
@@ -2,8 +2,13 @@
 
 #include "Sim/SimulatorCommon.h"
 #include "Sim/ITrackRayCastProvider.h"
+#include "Sim/TrackBVH.h"
+#include "Sim/TrackDistanceField.h"
+#include "Sim/TrackProfile.h"
+#include "Sim/TrackPack.h"
 #include "Car/CarSenseiData.h"
-#include "Core/VertexHash.h"
+#include "Sim/TrackLocator.h"
+#include "Core/UniformGrid.h"
 #include "Core/Spline3d.h"
 #include <unordered_set>
 
@@ -25,46 +30,101 @@ struct FatTrackPoint
 };
 #pragma pack(pop)
 
+// track collider of a single surface, or of all surfaces of one collision category when merged
+struct TrackMesh
+{
+	ICollisionObjectPtr collider;
+	ITriMeshPtr trimesh; // merged only, surfaces keep their own
+	uint32_t surfaceIndex = 0;
+	std::vector<uint32_t> triangleSurfaces; // merged only, surface index per triangle
+};
+
 struct Track : public ITrackRayCastProvider
 {
 	Track(Simulator* sim);
 	~Track();
 
-	bool init(const std::wstring& trackName);
+	bool init(const std::wstring& trackName, bool allowPack = true); // allowPack false: load sources for cooking, traced without time budget
 	void step(float dt);
 
 	// ITrackRayCastProvider
 	IRayCasterPtr createRayCaster(float length) override;
 	bool rayCast(const vec3f& pos, const vec3f& dir, float length, TrackRayCastHit& result) override;
 	bool rayCastWithRayCaster(const vec3f& pos, const vec3f& dir, IRayCasterPtr ray, TrackRayCastHit& result) override;
+	void rayCastBatch(const vec3f* pos, const vec3f* dir, size_t count, float length, TrackContactCache* const* caches, TrackRayCastHit* hits) override;
+	Surface* getHitSurface(const RayCastHit& hit) override;
 
+	bool loadPack(const std::wstring& path);
+	bool cookPack(const std::wstring& path);
 	void loadSurfaceBlob();
+	void initSurfaceMeshes(bool buildBVH);
+	void createSurfaceMeshes(std::vector<uint32_t>& firstMeshTriangles);
+	void createMergedMeshes(std::vector<uint32_t>& firstMeshTriangles);
+	bool rayCastBVH(const vec3f& pos, const vec3f& dir, float length, RayCastHit& result) const;
+	void rayCastBatchBVH(const vec3f* pos, const vec3f* dir, size_t count, float length, RayCastHit* hits) const;
+	bool rayCastCached(TrackContactCache& cache, const vec3f& pos, const vec3f& dir, float length, TrackRayCastHit& result); // false on cache miss (cache refilled, ray not resolved)
 	void loadPits();
 	
 	void initTrackPoints();
+	bool loadSplineConfig();
 	void loadSlimPoints();
 	void loadFatPoints();
 	void saveFatPoints();
 	void loadSenseiPoints(const std::wstring& modelName);
 	void saveSenseiPoints(const std::wstring& modelName);
-	void computeFatPoints();
+	bool computeFatPoints(); // false when trace time budget ran out, remaining points use untraced sides
+	void computeFatPoint(size_t pointId, bool traceSidesFlag);
+	bool loadFatPointsCheckpoint(std::vector<uint8_t>& done);
+	void saveFatPointsCheckpoint(const std::vector<uint8_t>& done);
+	uint64_t computeTraceSettingsHash() const;
+	uint64_t computeTraceConfigHash() const;
+	void initFatPointsGrid();
+	void initArcSpline();
+	void initBoundsSegments();
+	void initDistanceField();
+	void initProfile();
+	void updatePointCache(TrackPointCache& cache, const vec3f& pos, float radius) const;
+	void initPointCacheSegments(TrackPointCache& cache) const;
 	vec3f computeSideLocation(const SlimTrackPoint& slim, FatTrackPoint& fat, const TrackRayCastHit& origHit, const vec3f& rayStart, const vec3f& traceDir, int numSteps);
-	float rayCastTrackBounds(const vec3f& pos, const vec3f& dir, float maxDistance = 0.0f);
+	float rayCastTrackBounds(TrackPointCache& cache, const vec3f& pos, const vec3f& dir, float maxDistance = 0.0f) const;
+	void rayCastTrackBounds(TrackPointCache& cache, const ray3f* rays, size_t count, float* hits) const;
 	size_t getPointIdAtDistance(float distanceNorm) const;
 	size_t getPointIdAtLocation(const vec3f& pos) const;
+	size_t getPointIdNear(const vec3f& pos, size_t pointId) const;
+	bool updateLocator(TrackLocator& loc, const vec3f& pos) const;
 	vec3f getTrackDirectionAtDistance(float distanceNorm) const;
 	bool getDistanceAlongSplineAtLocation(const vec3f& pos, int pointId, Spline3dPointInfo& info) const;
+	void serializeState(StateArchive& ar);
 
 	std::wstring name;
 	std::wstring dataFolder;
 	float dynamicGripLevel = 1.0f;
 	float interpolateResolution = 0.1f;
+	float arcSplineStep = 1.0f;
+	float locatorResetDistance = 10.0f; // moving further than this in one update triggers global search
 	int interpolateStep = 0;
 	bool closedLoop = false;
 
 	Simulator* sim = nullptr;
+	int usePack = 1;
+	std::unique_ptr<TrackPack> pack; // mapped buffers outlive surfaces and meshes
 	std::vector<SurfacePtr> surfaces;
-	std::vector<ICollisionObjectPtr> colliders;
+	vec3f boundsMin;
+	vec3f boundsMax;
+	std::vector<std::unique_ptr<TrackMesh>> meshes;
+	std::vector<uint32_t> surfaceMeshes; // mesh index per surface
+	int mergeSurfaces = 0;
+	TrackBVH bvh; // surface index per triangle refers to surfaces
+	int useBVH = 1;
+	int useContactCache = 1;
+	float contactCacheMargin = 1.0f;
+	int contactCacheMaxTriangles = 64;
+	uint64_t contactCacheHits = 0;
+	uint64_t contactCacheMisses = 0;
+	std::vector<size_t> contactMissIds; // rayCastBatch scratch
+	std::vector<vec3f> contactMissPos;
+	std::vector<vec3f> contactMissDir;
+	std::vector<RayCastHit> contactMissHits;
 	std::vector<mat44f> pits;
 
 	std::vector<SlimTrackPoint> slimPoints;
@@ -72,11 +132,16 @@ struct Track : public ITrackRayCastProvider
 	std::vector<CarSenseiData> senseiPoints;
 
 	std::unique_ptr<struct BSpline3d> interpolatedSpline;
+	ArcSpline3d arcSpline;
+	TrackProfile profile; // features by distance along arcSpline
 	std::vector<float> fatPointDistances;
-	std::vector<size_t> nearbyPoints;
 
-	VertexHash fatPointsHash;
-	vec3f pointCachePos;
+	UniformGrid fatPointsGrid;
+	std::vector<vec4f> boundsSegments; // XZ start and extent of left (2 * id) and right (2 * id + 1) side to next point, zero for last point of open track
+	TrackDistanceField distanceField; // alternative to boundsSegments for rayCastTrackBounds
+	int useDistanceField = 0;
+	float distanceFieldCellSize = 0.5f;
+	float distanceFieldMaxDistance = 8.0f;
 	float computedTrackWidth = 0;
 	float computedTrackLength = 0;
 
@@ -88,6 +153,9 @@ struct Track : public ITrackRayCastProvider
 	float traceDiffGripMax = 0.1f;
 	float traceStep = 0.01f;
 	std::unordered_set<int> traceBadSectors;
+	int traceThreads = 0; // 0: hardware concurrency, parallel only with BVH (ODE ray is shared)
+	float traceCheckpointSeconds = 10.0f;
+	float traceTimeBudget = 0; // seconds, 0: unlimited
 
 	std::unique_ptr<IAvatar> avatar;
 };
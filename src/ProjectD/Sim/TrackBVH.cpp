@@ -0,0 +1,644 @@
+#include "Sim/TrackBVH.h"
+#include "Core/CpuFeatures.h"
+#include "Core/Diag.h"
+
+namespace D {
+
+void TrackBVH::clear()
+{
+	nodes.clear();
+	triangles.clear();
+}
+
+void TrackBVH::addMesh(const TriMeshVertex* vb, size_t numVertices, const TriMeshIndex* ib, size_t numIndices, uint32_t surfaceIndex, uint32_t firstMeshTriangle)
+{
+	triangles.reserve(triangles.size() + numIndices / 3);
+
+	for (size_t i = 0; i + 2 < numIndices; i += 3)
+	{
+		GUARD_FATAL(ib[i] < numVertices && ib[i + 1] < numVertices && ib[i + 2] < numVertices);
+
+		const vec3f v0(&vb[ib[i]].x);
+		const vec3f v1(&vb[ib[i + 1]].x);
+		const vec3f v2(&vb[ib[i + 2]].x);
+
+		Triangle tri;
+		tri.v0 = v0;
+		tri.e1 = v1 - v0;
+		tri.e2 = v2 - v0;
+		tri.surfaceIndex = surfaceIndex;
+		tri.meshTriangle = firstMeshTriangle + (uint32_t)(i / 3);
+
+		if (tri.e1.cross(tri.e2).sqlen() > 0.0f) // degenerate triangles never report hits
+			triangles.emplace_back(tri);
+	}
+}
+
+bool TrackBVH::validate(const Node* nodes, size_t numNodes, size_t numTriangles)
+{
+	if (!numNodes)
+		return false;
+
+	std::vector<uint8_t> depths(numNodes, 0);
+	for (size_t i = 0; i < numNodes; ++i)
+	{
+		const auto& node = nodes[i];
+		if (node.count)
+		{
+			if ((size_t)node.leftFirst + node.count > numTriangles)
+				return false;
+		}
+		else
+		{
+			if (node.leftFirst <= i || (size_t)node.leftFirst + 1 >= numNodes || depths[i] + 1 >= MaxDepth)
+				return false;
+			depths[node.leftFirst] = depths[node.leftFirst + 1] = (uint8_t)(depths[i] + 1);
+		}
+	}
+
+	return true;
+}
+
+void TrackBVH::build(int maxLeafSize)
+{
+	nodes.clear();
+	if (triangles.empty())
+		return;
+
+	const size_t numTris = triangles.size();
+	GUARD_FATAL(numTris < 0x7FFFFFFF);
+
+	std::vector<vec3f> centroids(numTris);
+	for (size_t i = 0; i < numTris; ++i)
+	{
+		const auto& tri = triangles[i];
+		centroids[i] = tri.v0 + (tri.e1 + tri.e2) * (1.0f / 3.0f);
+	}
+
+	nodes.reserve(numTris * 2);
+	nodes.emplace_back();
+	nodes[0].leftFirst = 0;
+	nodes[0].count = (uint32_t)numTris;
+	updateBounds(nodes[0]);
+
+	subdivide(0, tmax(maxLeafSize, 1), centroids);
+
+	nodes.shrink_to_fit();
+	log_printf(L"TrackBVH: triangles=%u nodes=%u", (unsigned int)numTris, (unsigned int)nodes.size());
+}
+
+void TrackBVH::updateBounds(Node& node) const
+{
+	node.bmin = vec3f(FLT_MAX, FLT_MAX, FLT_MAX);
+	node.bmax = vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	for (uint32_t i = 0; i < node.count; ++i)
+	{
+		const auto& tri = triangles[node.leftFirst + i];
+		const vec3f v[3] = { tri.v0, tri.v0 + tri.e1, tri.v0 + tri.e2 };
+
+		for (int k = 0; k < 3; ++k)
+		{
+			for (int a = 0; a < 3; ++a)
+			{
+				node.bmin[a] = tmin(node.bmin[a], v[k][a]);
+				node.bmax[a] = tmax(node.bmax[a], v[k][a]);
+			}
+		}
+	}
+}
+
+static float halfArea(const vec3f& bmin, const vec3f& bmax)
+{
+	const vec3f e = bmax - bmin;
+	return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+void TrackBVH::subdivide(uint32_t rootId, int maxLeafSize, std::vector<vec3f>& centroids)
+{
+	const int NumBins = 16;
+
+	struct Bin
+	{
+		vec3f bmin = vec3f(FLT_MAX, FLT_MAX, FLT_MAX);
+		vec3f bmax = vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		uint32_t count = 0;
+	};
+
+	std::vector<std::pair<uint32_t, int>> stack; // node, depth
+	stack.push_back({rootId, 1});
+
+	while (!stack.empty())
+	{
+		const uint32_t nodeId = stack.back().first;
+		const int depth = stack.back().second;
+		stack.pop_back();
+
+		const uint32_t first = nodes[nodeId].leftFirst;
+		const uint32_t count = nodes[nodeId].count;
+
+		if (count <= (uint32_t)maxLeafSize)
+			continue;
+
+		vec3f cmin(FLT_MAX, FLT_MAX, FLT_MAX);
+		vec3f cmax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			for (int a = 0; a < 3; ++a)
+			{
+				cmin[a] = tmin(cmin[a], centroids[i][a]);
+				cmax[a] = tmax(cmax[a], centroids[i][a]);
+			}
+		}
+
+		// binned SAH
+		int bestAxis = -1;
+		int bestSplit = 0;
+		float bestCost = FLT_MAX;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float extent = cmax[axis] - cmin[axis];
+			if (extent <= 1e-6f)
+				continue;
+
+			Bin bins[NumBins];
+			const float scale = NumBins / extent;
+
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const int b = tmin((int)((centroids[i][axis] - cmin[axis]) * scale), NumBins - 1);
+				const auto& tri = triangles[i];
+				const vec3f v[3] = { tri.v0, tri.v0 + tri.e1, tri.v0 + tri.e2 };
+
+				auto& bin = bins[b];
+				bin.count++;
+				for (int k = 0; k < 3; ++k)
+				{
+					for (int a = 0; a < 3; ++a)
+					{
+						bin.bmin[a] = tmin(bin.bmin[a], v[k][a]);
+						bin.bmax[a] = tmax(bin.bmax[a], v[k][a]);
+					}
+				}
+			}
+
+			float leftArea[NumBins - 1];
+			uint32_t leftCount[NumBins - 1];
+			Bin acc;
+			for (int i = 0; i < NumBins - 1; ++i)
+			{
+				acc.count += bins[i].count;
+				for (int a = 0; a < 3; ++a)
+				{
+					acc.bmin[a] = tmin(acc.bmin[a], bins[i].bmin[a]);
+					acc.bmax[a] = tmax(acc.bmax[a], bins[i].bmax[a]);
+				}
+				leftCount[i] = acc.count;
+				leftArea[i] = acc.count ? halfArea(acc.bmin, acc.bmax) : 0.0f;
+			}
+
+			acc = Bin();
+			for (int i = NumBins - 1; i > 0; --i)
+			{
+				acc.count += bins[i].count;
+				for (int a = 0; a < 3; ++a)
+				{
+					acc.bmin[a] = tmin(acc.bmin[a], bins[i].bmin[a]);
+					acc.bmax[a] = tmax(acc.bmax[a], bins[i].bmax[a]);
+				}
+
+				if (acc.count == 0 || leftCount[i - 1] == 0)
+					continue;
+
+				const float cost = leftCount[i - 1] * leftArea[i - 1] + acc.count * halfArea(acc.bmin, acc.bmax);
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = i;
+				}
+			}
+		}
+
+		if (bestAxis < 0) // all centroids coincide
+			continue;
+
+		// partition triangles by bin
+		const float scale = NumBins / (cmax[bestAxis] - cmin[bestAxis]);
+		uint32_t i = first;
+		uint32_t j = first + count - 1;
+		while (i <= j)
+		{
+			const int b = tmin((int)((centroids[i][bestAxis] - cmin[bestAxis]) * scale), NumBins - 1);
+			if (b < bestSplit)
+			{
+				++i;
+			}
+			else
+			{
+				std::swap(triangles[i], triangles[j]);
+				std::swap(centroids[i], centroids[j]);
+				if (j == 0)
+					break;
+				--j;
+			}
+		}
+
+		const uint32_t leftCount = i - first;
+		if (leftCount == 0 || leftCount == count)
+			continue;
+
+		const uint32_t leftId = (uint32_t)nodes.size();
+		nodes.emplace_back();
+		nodes.emplace_back();
+
+		auto& left = nodes[leftId];
+		left.leftFirst = first;
+		left.count = leftCount;
+		updateBounds(left);
+
+		auto& right = nodes[leftId + 1];
+		right.leftFirst = i;
+		right.count = count - leftCount;
+		updateBounds(right);
+
+		auto& node = nodes[nodeId];
+		node.leftFirst = leftId;
+		node.count = 0;
+
+		// traversal stack holds at most one entry per level
+		GUARD_FATAL(depth + 1 < MaxDepth);
+		stack.push_back({leftId + 1, depth + 1});
+		stack.push_back({leftId, depth + 1});
+	}
+}
+
+static inline bool rayBox(const vec3f& org, const vec3f& invDir, float tmaxRay, const vec3f& bmin, const vec3f& bmax, float& tnear)
+{
+	const float tx1 = (bmin.x - org.x) * invDir.x, tx2 = (bmax.x - org.x) * invDir.x;
+	float t0 = tmin(tx1, tx2), t1 = tmax(tx1, tx2);
+
+	const float ty1 = (bmin.y - org.y) * invDir.y, ty2 = (bmax.y - org.y) * invDir.y;
+	t0 = tmax(t0, tmin(ty1, ty2)); t1 = tmin(t1, tmax(ty1, ty2));
+
+	const float tz1 = (bmin.z - org.z) * invDir.z, tz2 = (bmax.z - org.z) * invDir.z;
+	t0 = tmax(t0, tmin(tz1, tz2)); t1 = tmin(t1, tmax(tz1, tz2));
+
+	tnear = t0;
+	return (t1 >= t0) && (t1 >= 0.0f) && (t0 <= tmaxRay);
+}
+
+// Moller-Trumbore, back faces culled like ODE rays (dGeomRaySetBackfaceCull)
+static inline bool intersectTriangle(const TrackBVH::Triangle& tri, const vec3f& org, const vec3f& dir, float& t)
+{
+	const vec3f p = dir.cross(tri.e2);
+	const float det = tri.e1 * p;
+	if (det < 1e-12f)
+		return false;
+
+	const float invDet = 1.0f / det;
+	const vec3f s = org - tri.v0;
+	const float u = (s * p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	const vec3f q = s.cross(tri.e1);
+	const float v = (dir * q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	t = (tri.e2 * q) * invDet;
+	return (t >= 0.0f);
+}
+
+// equal distances resolve to lower triangle index so every query path returns the same hit
+static inline bool isCloser(float t, uint32_t tri, float bestT, uint32_t bestTri)
+{
+	return (t < bestT) || (t == bestT && tri < bestTri);
+}
+
+bool TrackBVH::rayCast(const vec3f& org, const vec3f& dir, float length, Hit& hit) const
+{
+	if (nodes.empty())
+		return false;
+
+	const vec3f invDir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+	float bestT = length;
+	uint32_t bestTri = 0xFFFFFFFF;
+
+	uint32_t stack[MaxDepth];
+	int stackSize = 0;
+
+	float tnear;
+	if (!rayBox(org, invDir, bestT, nodes[0].bmin, nodes[0].bmax, tnear))
+		return false;
+
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+
+		if (node.count)
+		{
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				float t;
+				if (intersectTriangle(triangles[node.leftFirst + i], org, dir, t) && isCloser(t, node.leftFirst + i, bestT, bestTri))
+				{
+					bestT = t;
+					bestTri = node.leftFirst + i;
+				}
+			}
+			continue;
+		}
+
+		// push far child first so near one is processed next
+		const uint32_t c0 = node.leftFirst;
+		const uint32_t c1 = node.leftFirst + 1;
+		float t0, t1;
+		const bool hit0 = rayBox(org, invDir, bestT, nodes[c0].bmin, nodes[c0].bmax, t0);
+		const bool hit1 = rayBox(org, invDir, bestT, nodes[c1].bmin, nodes[c1].bmax, t1);
+
+		if (hit0 && hit1)
+		{
+			if (t0 <= t1)
+			{
+				stack[stackSize++] = c1;
+				stack[stackSize++] = c0;
+			}
+			else
+			{
+				stack[stackSize++] = c0;
+				stack[stackSize++] = c1;
+			}
+		}
+		else if (hit0 || hit1)
+		{
+			stack[stackSize++] = hit0 ? c0 : c1;
+		}
+	}
+
+	if (bestTri == 0xFFFFFFFF)
+		return false;
+
+	hit.t = bestT;
+	hit.triangle = bestTri;
+	return true;
+}
+
+struct RayPacket
+{
+	__m256 ox, oy, oz;
+	__m256 idx, idy, idz;
+};
+
+static D_TARGET_AVX2 inline int testPacketBox(const RayPacket& rp, const TrackBVH::Node& n, const __m256& bestT, float& tnearMin)
+{
+	const __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(n.bmin.x), rp.ox), rp.idx);
+	const __m256 tx2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(n.bmax.x), rp.ox), rp.idx);
+	const __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(n.bmin.y), rp.oy), rp.idy);
+	const __m256 ty2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(n.bmax.y), rp.oy), rp.idy);
+	const __m256 tz1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(n.bmin.z), rp.oz), rp.idz);
+	const __m256 tz2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(n.bmax.z), rp.oz), rp.idz);
+
+	const __m256 t0 = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(tx1, tx2), _mm256_min_ps(ty1, ty2)), _mm256_min_ps(tz1, tz2));
+	const __m256 t1 = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(tx1, tx2), _mm256_max_ps(ty1, ty2)), _mm256_max_ps(tz1, tz2));
+
+	const __m256 m = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(t1, t0, _CMP_GE_OQ), _mm256_cmp_ps(t1, _mm256_setzero_ps(), _CMP_GE_OQ)), _mm256_cmp_ps(t0, bestT, _CMP_LE_OQ));
+	const int mask = _mm256_movemask_ps(m);
+
+	if (mask)
+	{
+		alignas(32) float tn[TrackBVH::PacketSize];
+		_mm256_store_ps(tn, _mm256_blendv_ps(_mm256_set1_ps(FLT_MAX), t0, m));
+		tnearMin = tn[0];
+		for (int i = 1; i < TrackBVH::PacketSize; ++i)
+			tnearMin = tmin(tnearMin, tn[i]);
+	}
+	return mask;
+}
+
+static D_TARGET_AVX2 void rayCastPacketAVX(const TrackBVH& bvh, const vec3f* org, const vec3f* dir, int count, float length, TrackBVH::Hit* hits, uint8_t* hasHit)
+{
+	const int PacketSize = TrackBVH::PacketSize;
+	const auto& nodes = bvh.nodes;
+	const auto& triangles = bvh.triangles;
+
+	// SoA lanes, unused lanes replicate ray 0 with negative range so they never hit
+	alignas(32) float lane[7][PacketSize];
+	for (int i = 0; i < PacketSize; ++i)
+	{
+		const int r = (i < count) ? i : 0;
+		lane[0][i] = org[r].x; lane[1][i] = org[r].y; lane[2][i] = org[r].z;
+		lane[3][i] = dir[r].x; lane[4][i] = dir[r].y; lane[5][i] = dir[r].z;
+		lane[6][i] = (i < count) ? length : -1.0f;
+	}
+
+	RayPacket rp;
+	rp.ox = _mm256_load_ps(lane[0]); rp.oy = _mm256_load_ps(lane[1]); rp.oz = _mm256_load_ps(lane[2]);
+	const __m256 ox = rp.ox, oy = rp.oy, oz = rp.oz;
+	const __m256 dx = _mm256_load_ps(lane[3]), dy = _mm256_load_ps(lane[4]), dz = _mm256_load_ps(lane[5]);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	rp.idx = _mm256_div_ps(one, dx); rp.idy = _mm256_div_ps(one, dy); rp.idz = _mm256_div_ps(one, dz);
+	const __m256 detEps = _mm256_set1_ps(1e-12f);
+
+	__m256 bestT = _mm256_load_ps(lane[6]);
+	__m256i bestTri = _mm256_set1_epi32(INT32_MAX);
+
+	uint32_t stack[TrackBVH::MaxDepth];
+	int stackSize = 0;
+
+	float tnear;
+	if (testPacketBox(rp, nodes[0], bestT, tnear))
+		stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const TrackBVH::Node& node = nodes[stack[--stackSize]];
+
+		if (node.count)
+		{
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				const uint32_t triId = node.leftFirst + i;
+				const TrackBVH::Triangle& tri = triangles[triId];
+
+				const __m256 e1x = _mm256_set1_ps(tri.e1.x), e1y = _mm256_set1_ps(tri.e1.y), e1z = _mm256_set1_ps(tri.e1.z);
+				const __m256 e2x = _mm256_set1_ps(tri.e2.x), e2y = _mm256_set1_ps(tri.e2.y), e2z = _mm256_set1_ps(tri.e2.z);
+
+				// Moller-Trumbore, back faces culled, 8 rays vs 1 triangle
+				const __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+				const __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+				const __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+				const __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+				__m256 m = _mm256_cmp_ps(det, detEps, _CMP_GE_OQ);
+				if (!_mm256_movemask_ps(m))
+					continue;
+
+				const __m256 invDet = _mm256_div_ps(one, det);
+				const __m256 sx = _mm256_sub_ps(ox, _mm256_set1_ps(tri.v0.x));
+				const __m256 sy = _mm256_sub_ps(oy, _mm256_set1_ps(tri.v0.y));
+				const __m256 sz = _mm256_sub_ps(oz, _mm256_set1_ps(tri.v0.z));
+
+				const __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), invDet);
+				m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+				if (!_mm256_movemask_ps(m))
+					continue;
+
+				const __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+				const __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+				const __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+
+				const __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), invDet);
+				m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+
+				const __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), invDet);
+				const __m256i vTri = _mm256_set1_epi32((int)triId);
+				const __m256 tieBreak = _mm256_and_ps(_mm256_cmp_ps(t, bestT, _CMP_EQ_OQ), _mm256_castsi256_ps(_mm256_cmpgt_epi32(bestTri, vTri)));
+				m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_or_ps(_mm256_cmp_ps(t, bestT, _CMP_LT_OQ), tieBreak)));
+
+				bestT = _mm256_blendv_ps(bestT, t, m);
+				bestTri = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestTri), _mm256_castsi256_ps(vTri), m));
+			}
+			continue;
+		}
+
+		const uint32_t c0 = node.leftFirst;
+		const uint32_t c1 = node.leftFirst + 1;
+		float t0 = 0, t1 = 0;
+		const int hit0 = testPacketBox(rp, nodes[c0], bestT, t0);
+		const int hit1 = testPacketBox(rp, nodes[c1], bestT, t1);
+
+		if (hit0 && hit1)
+		{
+			if (t0 <= t1)
+			{
+				stack[stackSize++] = c1;
+				stack[stackSize++] = c0;
+			}
+			else
+			{
+				stack[stackSize++] = c0;
+				stack[stackSize++] = c1;
+			}
+		}
+		else if (hit0 || hit1)
+		{
+			stack[stackSize++] = hit0 ? c0 : c1;
+		}
+	}
+
+	alignas(32) float outT[PacketSize];
+	alignas(32) int32_t outTri[PacketSize];
+	_mm256_store_ps(outT, bestT);
+	_mm256_store_si256((__m256i*)outTri, bestTri);
+
+	for (int i = 0; i < count; ++i)
+	{
+		hasHit[i] = (outTri[i] != INT32_MAX) ? 1 : 0;
+		hits[i].t = outT[i];
+		hits[i].triangle = (uint32_t)outTri[i];
+	}
+}
+
+void TrackBVH::rayCastPacket(const vec3f* org, const vec3f* dir, int count, float length, Hit* hits, uint8_t* hasHit) const
+{
+	GUARD_FATAL(count > 0 && count <= PacketSize);
+
+	if (nodes.empty())
+	{
+		memset(hasHit, 0, count);
+		return;
+	}
+
+	if (cpuHasAvx2())
+	{
+		rayCastPacketAVX(*this, org, dir, count, length, hits, hasHit);
+		return;
+	}
+
+	for (int i = 0; i < count; ++i)
+		hasHit[i] = rayCast(org[i], dir[i], length, hits[i]) ? 1 : 0;
+}
+
+bool TrackBVH::rayCastList(const uint32_t* list, size_t count, const vec3f& org, const vec3f& dir, float length, Hit& hit) const
+{
+	float bestT = length;
+	uint32_t bestTri = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float t;
+		if (intersectTriangle(triangles[list[i]], org, dir, t) && isCloser(t, list[i], bestT, bestTri))
+		{
+			bestT = t;
+			bestTri = list[i];
+		}
+	}
+
+	if (bestTri == 0xFFFFFFFF)
+		return false;
+
+	hit.t = bestT;
+	hit.triangle = bestTri;
+	return true;
+}
+
+bool TrackBVH::queryBox(const vec3f& bmin, const vec3f& bmax, std::vector<uint32_t>& result, size_t maxCount) const
+{
+	result.clear();
+	if (nodes.empty())
+		return true;
+
+	uint32_t stack[MaxDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+
+		if (node.bmin.x > bmax.x || node.bmax.x < bmin.x || node.bmin.y > bmax.y || node.bmax.y < bmin.y || node.bmin.z > bmax.z || node.bmax.z < bmin.z)
+			continue;
+
+		if (node.count == 0)
+		{
+			stack[stackSize++] = node.leftFirst + 1;
+			stack[stackSize++] = node.leftFirst;
+			continue;
+		}
+
+		for (uint32_t i = 0; i < node.count; ++i)
+		{
+			const auto& tri = triangles[node.leftFirst + i];
+			const vec3f v1 = tri.v0 + tri.e1;
+			const vec3f v2 = tri.v0 + tri.e2;
+
+			if (tmax(tri.v0.x, tmax(v1.x, v2.x)) < bmin.x || tmin(tri.v0.x, tmin(v1.x, v2.x)) > bmax.x
+				|| tmax(tri.v0.y, tmax(v1.y, v2.y)) < bmin.y || tmin(tri.v0.y, tmin(v1.y, v2.y)) > bmax.y
+				|| tmax(tri.v0.z, tmax(v1.z, v2.z)) < bmin.z || tmin(tri.v0.z, tmin(v1.z, v2.z)) > bmax.z)
+				continue;
+
+			if (result.size() >= maxCount)
+				return false;
+
+			result.push_back(node.leftFirst + i);
+		}
+	}
+
+	return true;
+}
+
+vec3f TrackBVH::getNormal(uint32_t triangle, const vec3f& dir) const
+{
+	const auto& tri = triangles[triangle];
+	vec3f n = tri.e1.cross(tri.e2).get_norm();
+	if (n * dir > 0.0f)
+		n *= -1.0f;
+	return n;
+}
+
+}
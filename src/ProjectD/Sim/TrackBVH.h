@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Core/Math.h"
+#include "Physics/ITriMesh.h"
+#include <vector>
+
+namespace D {
+
+// Flattened bounding volume hierarchy over static track triangles, built once at track load.
+// Nodes are stored depth-first with siblings adjacent, triangles are reordered to leaf order.
+struct TrackBVH
+{
+	static const int MaxDepth = 64;
+	static const int PacketSize = 8;
+
+	struct Node
+	{
+		vec3f bmin;
+		uint32_t leftFirst = 0; // count == 0: index of left child (right = left + 1), else first triangle
+		vec3f bmax;
+		uint32_t count = 0;
+	};
+
+	struct Triangle
+	{
+		vec3f v0;
+		vec3f e1; // v1 - v0
+		vec3f e2; // v2 - v0
+		uint32_t surfaceIndex = 0;
+		uint32_t meshTriangle = 0; // triangle in track collider mesh
+	};
+
+	struct Hit
+	{
+		float t = 0;
+		uint32_t triangle = 0;
+	};
+
+	void clear();
+	void addMesh(const TriMeshVertex* vb, size_t numVertices, const TriMeshIndex* ib, size_t numIndices, uint32_t surfaceIndex, uint32_t firstMeshTriangle = 0);
+	void build(int maxLeafSize = 4);
+
+	// checks child and triangle ranges of cooked nodes, children must follow their parent within MaxDepth
+	static bool validate(const Node* nodes, size_t numNodes, size_t numTriangles);
+
+	inline bool isValid() const { return !nodes.empty(); }
+
+	// closest hit along normalized dir within [0, length]
+	bool rayCast(const vec3f& org, const vec3f& dir, float length, Hit& hit) const;
+
+	// closest hit among listed triangles only
+	bool rayCastList(const uint32_t* list, size_t count, const vec3f& org, const vec3f& dir, float length, Hit& hit) const;
+
+	// triangles whose bounds overlap the box, false if there are more than maxCount
+	bool queryBox(const vec3f& bmin, const vec3f& bmax, std::vector<uint32_t>& result, size_t maxCount) const;
+
+	// up to PacketSize rays traversed together with AVX, rays should be spatially coherent (e.g. tyres of one or two cars)
+	void rayCastPacket(const vec3f* org, const vec3f* dir, int count, float length, Hit* hits, uint8_t* hasHit) const;
+
+	// unit normal facing against dir, same convention as ODE ray vs trimesh
+	vec3f getNormal(uint32_t triangle, const vec3f& dir) const;
+
+	// internals
+
+	void subdivide(uint32_t nodeId, int maxLeafSize, std::vector<vec3f>& centroids);
+	void updateBounds(Node& node) const;
+
+	std::vector<Node> nodes;
+	std::vector<Triangle> triangles;
+};
+
+}
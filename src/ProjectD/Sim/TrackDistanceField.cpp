@@ -0,0 +1,256 @@
+#include "Sim/TrackDistanceField.h"
+#include "Core/Diag.h"
+#include "Core/ThreadPool.h"
+
+namespace D {
+
+inline float cross2(float ax, float az, float bx, float bz) { return ax * bz - az * bx; }
+
+inline bool isPointInTriangle(float px, float pz, float ax, float az, float bx, float bz, float cx, float cz)
+{
+	// either winding
+	const float d1 = cross2(bx - ax, bz - az, px - ax, pz - az);
+	const float d2 = cross2(cx - bx, cz - bz, px - bx, pz - bz);
+	const float d3 = cross2(ax - cx, az - cz, px - cx, pz - cz);
+	const bool hasNeg = (d1 < 0) || (d2 < 0) || (d3 < 0);
+	const bool hasPos = (d1 > 0) || (d2 > 0) || (d3 > 0);
+	return !(hasNeg && hasPos);
+}
+
+inline float getSegmentDistanceSq(float px, float pz, const vec4f& seg)
+{
+	const float dx = px - seg.x, dz = pz - seg.y;
+	const float lenSq = seg.z * seg.z + seg.w * seg.w;
+	const float u = (lenSq > 0.0f) ? tclamp((dx * seg.z + dz * seg.w) / lenSq, 0.0f, 1.0f) : 0.0f;
+	const float ex = dx - seg.z * u, ez = dz - seg.w * u;
+	return ex * ex + ez * ez;
+}
+
+//=============================================================================
+
+void TrackDistanceField::clear()
+{
+	info = TrackDistanceFieldInfo();
+	tiles.clear();
+	cells.clear();
+}
+
+void TrackDistanceField::initScale()
+{
+	quantScale = 127.0f / info.maxDistance;
+	dequantScale = info.maxDistance / 127.0f;
+}
+
+bool TrackDistanceField::assign(const TrackDistanceFieldInfo& _info, const uint32_t* _tiles, size_t numTiles, const int8_t* _cells, size_t numCells)
+{
+	clear();
+
+	const int TileCells = TileSize * TileSize;
+	if (_info.tilesX <= 0 || _info.tilesZ <= 0 || _info.cellSize <= 0.0f || _info.maxDistance <= 0.0f ||
+		numTiles != (size_t)_info.tilesX * (size_t)_info.tilesZ || numCells != (size_t)_info.numTileCells * TileCells)
+		return false;
+
+	for (size_t i = 0; i < numTiles; ++i)
+	{
+		if (!(_tiles[i] & ConstantTile) && _tiles[i] >= _info.numTileCells)
+			return false;
+	}
+
+	info = _info;
+	tiles.assign(_tiles, _tiles + numTiles);
+	cells.assign(_cells, _cells + numCells);
+	initScale();
+	return true;
+}
+
+void TrackDistanceField::bake(const vec4f* segments, size_t numPoints, bool closedLoop, const UniformGrid& grid, float pointMargin, float cellSize, float maxDistance, int numThreads)
+{
+	clear();
+
+	const size_t numSegmentPoints = closedLoop ? numPoints : numPoints - 1;
+	if (numPoints < 2 || grid.isEmpty() || cellSize <= 0.0f || maxDistance <= 0.0f)
+		return;
+
+	float minX = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxZ = -FLT_MAX;
+	for (size_t i = 0; i < numSegmentPoints * 2; ++i)
+	{
+		const auto& seg = segments[i];
+		minX = tmin(minX, tmin(seg.x, seg.x + seg.z)); maxX = tmax(maxX, tmax(seg.x, seg.x + seg.z));
+		minZ = tmin(minZ, tmin(seg.y, seg.y + seg.w)); maxZ = tmax(maxZ, tmax(seg.y, seg.y + seg.w));
+	}
+
+	const int TileCells = TileSize * TileSize;
+	const float tileExtent = cellSize * (float)TileSize;
+
+	info.originX = minX - maxDistance;
+	info.originZ = minZ - maxDistance;
+	info.cellSize = cellSize;
+	info.maxDistance = maxDistance;
+	info.tilesX = (int)((maxX + maxDistance - info.originX) / tileExtent) + 1;
+	info.tilesZ = (int)((maxZ + maxDistance - info.originZ) / tileExtent) + 1;
+	initScale();
+
+	const int8_t outside = -127;
+	const float searchMargin = maxDistance + pointMargin;
+	const float maxDistanceSq = maxDistance * maxDistance;
+
+	std::unique_ptr<ThreadPool> pool;
+	if (numThreads != 1)
+		pool.reset(new ThreadPool(numThreads));
+
+	// one row of tiles at a time keeps temporary samples small on big tracks
+	std::vector<int8_t> rowCells((size_t)info.tilesX * TileCells);
+	std::vector<uint8_t> rowConstant(info.tilesX);
+	tiles.resize((size_t)info.tilesX * (size_t)info.tilesZ);
+
+	auto bakeTile = [&](int tx, int tz)
+	{
+		int8_t* out = &rowCells[(size_t)tx * TileCells];
+		const float x0 = info.originX + (float)(tx * TileSize) * cellSize;
+		const float z0 = info.originZ + (float)(tz * TileSize) * cellSize;
+		const float x1 = x0 + (float)(TileSize - 1) * cellSize;
+		const float z1 = z0 + (float)(TileSize - 1) * cellSize;
+
+		std::vector<uint32_t> points;
+		grid.queryRect(x0 - searchMargin, z0 - searchMargin, x1 + searchMargin, z1 + searchMargin, points);
+
+		if (points.empty())
+		{
+			memset(out, outside, TileCells);
+			rowConstant[tx] = 1;
+			return;
+		}
+
+		for (int sz = 0; sz < TileSize; ++sz)
+		{
+			for (int sx = 0; sx < TileSize; ++sx)
+			{
+				const float px = x0 + (float)sx * cellSize;
+				const float pz = z0 + (float)sz * cellSize;
+
+				float distSq = maxDistanceSq;
+				bool inside = false;
+
+				for (uint32_t id : points)
+				{
+					if (id >= numSegmentPoints)
+						continue;
+
+					const auto& left = segments[id * 2];
+					const auto& right = segments[id * 2 + 1];
+
+					distSq = tmin(distSq, tmin(getSegmentDistanceSq(px, pz, left), getSegmentDistanceSq(px, pz, right)));
+
+					if (!inside)
+					{
+						// drivable quad between this point and next
+						const float l1x = left.x + left.z, l1z = left.y + left.w;
+						const float r1x = right.x + right.z, r1z = right.y + right.w;
+						inside = isPointInTriangle(px, pz, left.x, left.y, right.x, right.y, r1x, r1z) ||
+							isPointInTriangle(px, pz, left.x, left.y, r1x, r1z, l1x, l1z);
+					}
+				}
+
+				const float dist = sqrtf(distSq);
+				out[sz * TileSize + sx] = (int8_t)tclamp(roundToInt((inside ? dist : -dist) * quantScale), -127, 127);
+			}
+		}
+
+		bool constant = true;
+		for (int i = 1; i < TileCells && constant; ++i)
+			constant = (out[i] == out[0]);
+		rowConstant[tx] = constant ? 1 : 0;
+	};
+
+	for (int tz = 0; tz < info.tilesZ; ++tz)
+	{
+		if (pool)
+			pool->parallelFor((size_t)info.tilesX, [&](size_t tx) { bakeTile((int)tx, tz); });
+		else
+			for (int tx = 0; tx < info.tilesX; ++tx)
+				bakeTile(tx, tz);
+
+		for (int tx = 0; tx < info.tilesX; ++tx)
+		{
+			const int8_t* src = &rowCells[(size_t)tx * TileCells];
+			auto& tile = tiles[(size_t)tz * info.tilesX + tx];
+
+			if (rowConstant[tx])
+			{
+				tile = ConstantTile | (uint8_t)src[0];
+			}
+			else
+			{
+				tile = info.numTileCells++;
+				cells.insert(cells.end(), src, src + TileCells);
+			}
+		}
+	}
+
+	log_printf(L"TrackDistanceField: bake: tiles=%dx%d stored=%d cellSize=%.2f maxDistance=%.2f size=%dKB",
+		info.tilesX, info.tilesZ, (int)info.numTileCells, cellSize, maxDistance, (int)((tiles.size() * sizeof(uint32_t) + cells.size()) / 1024));
+}
+
+int8_t TrackDistanceField::getSample(int sx, int sz) const
+{
+	const int tx = sx / TileSize, tz = sz / TileSize;
+	if (sx < 0 || sz < 0 || tx >= info.tilesX || tz >= info.tilesZ)
+		return -127;
+
+	const uint32_t tile = tiles[(size_t)tz * info.tilesX + tx];
+	if (tile & ConstantTile)
+		return (int8_t)(tile & 0xFF);
+
+	return cells[(size_t)tile * (TileSize * TileSize) + (sz % TileSize) * TileSize + (sx % TileSize)];
+}
+
+float TrackDistanceField::sample(float x, float z) const
+{
+	const float fx = (x - info.originX) / info.cellSize;
+	const float fz = (z - info.originZ) / info.cellSize;
+	const int sx = floorToInt(fx);
+	const int sz = floorToInt(fz);
+	const float u = fx - (float)sx;
+	const float v = fz - (float)sz;
+
+	const float s00 = getSample(sx, sz), s10 = getSample(sx + 1, sz);
+	const float s01 = getSample(sx, sz + 1), s11 = getSample(sx + 1, sz + 1);
+
+	return ((s00 + (s10 - s00) * u) * (1.0f - v) + (s01 + (s11 - s01) * u) * v) * dequantScale;
+}
+
+bool TrackDistanceField::trace(float x, float z, float dx, float dz, float length, float& t) const
+{
+	const float minStep = info.cellSize * 0.25f;
+	const float hitDistance = info.cellSize * 0.05f;
+
+	float prev = sample(x, z);
+	t = 0;
+
+	if (fabsf(prev) < hitDistance)
+		return true;
+
+	// no step cap, every step advances by at least minStep so the whole length is traced
+	while (t < length)
+	{
+		const float next = tmin(t + tmax(fabsf(prev), minStep), length);
+		const float d = sample(x + dx * next, z + dz * next);
+
+		// side crossed between samples
+		if ((d > 0.0f) != (prev > 0.0f))
+		{
+			t += (next - t) * (prev / (prev - d));
+			return true;
+		}
+
+		t = next;
+		if (fabsf(d) < hitDistance)
+			return true;
+
+		prev = d;
+	}
+
+	return false;
+}
+
+}
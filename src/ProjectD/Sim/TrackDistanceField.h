@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Core/Math.h"
+#include "Core/UniformGrid.h"
+#include <vector>
+
+namespace D {
+
+struct TrackDistanceFieldInfo
+{
+	float originX = 0; // world position of sample (0, 0)
+	float originZ = 0;
+	float cellSize = 0.5f;
+	float maxDistance = 8.0f; // values are clamped to +-maxDistance
+	int32_t tilesX = 0;
+	int32_t tilesZ = 0;
+	uint32_t numTileCells = 0; // stored (non constant) tiles
+	uint32_t reserved = 0;
+};
+
+// Signed 2D (XZ) distance to track side splines, positive on drivable area, baked from fat point sides.
+// Samples are int8 quantized and grouped in TileSize^2 tiles, tiles with a single value store no samples.
+struct TrackDistanceField
+{
+	static const int TileSize = 16;
+	static const uint32_t ConstantTile = 0x80000000; // tile flag, low byte holds the value
+
+	void clear();
+
+	// segments: XZ start and extent, left (2 * id) and right (2 * id + 1) side of every point in grid
+	// open tracks ignore segments of the last point (they wrap back to point 0)
+	void bake(const vec4f* segments, size_t numPoints, bool closedLoop, const UniformGrid& grid, float pointMargin, float cellSize, float maxDistance, int numThreads);
+
+	// loads cooked data, false if sizes don't match info
+	bool assign(const TrackDistanceFieldInfo& info, const uint32_t* tiles, size_t numTiles, const int8_t* cells, size_t numCells);
+
+	inline bool isValid() const { return !tiles.empty(); }
+
+	// bilinear sample, -maxDistance outside of baked area
+	float sample(float x, float z) const;
+
+	// sphere traces normalized XZ direction, distance to first side crossing or false within length
+	bool trace(float x, float z, float dx, float dz, float length, float& t) const;
+
+	// internals
+
+	void initScale();
+	int8_t getSample(int sx, int sz) const;
+
+	TrackDistanceFieldInfo info;
+	std::vector<uint32_t> tiles; // offset of tile in cells (in tiles) or ConstantTile | value
+	std::vector<int8_t> cells;
+	float quantScale = 127.0f / 8.0f;
+	float dequantScale = 8.0f / 127.0f;
+};
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Core/Math.h"
+#include <vector>
+
+namespace D {
+
+// fat points around last query position, owned by each caller (car, renderer)
+struct TrackPointCache
+{
+	vec3f pos = vec3f(0, -10000, 0);
+	float radius = 0;
+	std::vector<uint32_t> points;
+	std::vector<float> segments; // boundary segments of points in SoA blocks: ax, az, ex, ez (each segmentStride long)
+	uint32_t segmentStride = 0; // multiple of 8, padding is degenerate
+};
+
+// per-car state of Track::updateLocator, refined incrementally from previous step
+struct TrackLocator
+{
+	vec3f pos; // query position of last update
+	vec3f splinePos;
+	float distance = 0; // along interpolated spline
+	int32_t pointId = 0; // nearest fat point
+	int32_t nodeId = 0; // nearest interpolated spline node
+	int32_t valid = 0;
+};
+
+}
@@ -0,0 +1,157 @@
+#include "Sim/TrackPack.h"
+#include "Physics/ITriMesh.h"
+#include <filesystem>
+
+namespace D {
+
+static const size_t TrackPackAlignment = 64;
+
+inline uint64_t alignPackOffset(uint64_t offset)
+{
+	return (offset + (TrackPackAlignment - 1)) & ~(uint64_t)(TrackPackAlignment - 1);
+}
+
+void TrackPackWriter::add(TrackPackSectionId id, const void* data, size_t elementSize, size_t count)
+{
+	Item item;
+	item.section.id = (uint32_t)id;
+	item.section.elementSize = (uint32_t)elementSize;
+	item.section.count = (uint64_t)count;
+	item.data.resize(elementSize * count);
+	if (!item.data.empty())
+		memcpy(item.data.data(), data, item.data.size());
+	items.emplace_back(std::move(item));
+}
+
+bool TrackPackWriter::save(const wchar_t* filename, TrackPackHeader header)
+{
+	header.magic = TrackPackHeader::Magic;
+	header.version = TrackPackHeader::Version;
+	header.numSections = (uint32_t)items.size();
+	header.indexSize = (uint32_t)sizeof(TriMeshIndex);
+
+	uint64_t offset = alignPackOffset(sizeof(TrackPackHeader) + sizeof(TrackPackSection) * items.size());
+	for (auto& item : items)
+	{
+		item.section.offset = offset;
+		offset = alignPackOffset(offset + item.data.size());
+	}
+
+	std::vector<uint8_t> buffer((size_t)offset, 0);
+	memcpy(buffer.data(), &header, sizeof(header));
+
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		const auto& item = items[i];
+		memcpy(buffer.data() + sizeof(TrackPackHeader) + sizeof(TrackPackSection) * i, &item.section, sizeof(TrackPackSection));
+		if (!item.data.empty())
+			memcpy(buffer.data() + item.section.offset, item.data.data(), item.data.size());
+	}
+
+	// written aside and renamed, the old package may still be mapped by a loaded track
+	const std::wstring tmpName = std::wstring(filename) + L".tmp";
+	{
+		FileHandle file;
+		if (!file.open(tmpName.c_str(), L"wb"))
+		{
+			log_printf(L"TrackPackWriter: failed to open %s", tmpName.c_str());
+			return false;
+		}
+
+		if (fwrite(buffer.data(), buffer.size(), 1, file.fd) != 1)
+		{
+			log_printf(L"TrackPackWriter: failed to write %s", tmpName.c_str());
+			return false;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(std::filesystem::path{tmpName}, std::filesystem::path{filename}, ec);
+	if (ec)
+	{
+		log_printf(L"TrackPackWriter: failed to replace %s: %S", filename, ec.message().c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool TrackPack::open(const wchar_t* filename)
+{
+	close();
+
+	if (!file.open(filename))
+		return false;
+
+	const auto* data = (const uint8_t*)file.data();
+	const size_t size = file.size();
+
+	const auto* h = (const TrackPackHeader*)data;
+	if (size < sizeof(TrackPackHeader) || h->magic != TrackPackHeader::Magic || h->version != TrackPackHeader::Version)
+	{
+		log_printf(L"TrackPack: invalid header: %s", filename);
+		close();
+		return false;
+	}
+
+	if (h->indexSize != sizeof(TriMeshIndex))
+	{
+		log_printf(L"TrackPack: indexSize=%u does not match build: %s", h->indexSize, filename);
+		close();
+		return false;
+	}
+
+	const auto* s = (const TrackPackSection*)(data + sizeof(TrackPackHeader));
+	if (sizeof(TrackPackHeader) + sizeof(TrackPackSection) * (size_t)h->numSections > size)
+	{
+		close();
+		return false;
+	}
+
+	for (uint32_t i = 0; i < h->numSections; ++i)
+	{
+		if (s[i].offset + s[i].count * s[i].elementSize > size)
+		{
+			log_printf(L"TrackPack: truncated section id=%u: %s", s[i].id, filename);
+			close();
+			return false;
+		}
+	}
+
+	header = h;
+	sections = s;
+	return true;
+}
+
+void TrackPack::close()
+{
+	header = nullptr;
+	sections = nullptr;
+	file.close();
+}
+
+const void* TrackPack::getSection(TrackPackSectionId id, size_t elementSize, size_t& count) const
+{
+	count = 0;
+	if (!header)
+		return nullptr;
+
+	for (uint32_t i = 0; i < header->numSections; ++i)
+	{
+		const auto& s = sections[i];
+		if (s.id == (uint32_t)id)
+		{
+			if (s.elementSize != elementSize)
+			{
+				log_printf(L"TrackPack: section id=%u elementSize=%u expected=%u", s.id, s.elementSize, (uint32_t)elementSize);
+				return nullptr;
+			}
+			count = (size_t)s.count;
+			return (const uint8_t*)file.data() + s.offset;
+		}
+	}
+
+	return nullptr;
+}
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Core/Common.h"
+#include "Core/Math.h"
+#include "Core/MappedFile.h"
+#include <vector>
+
+namespace D {
+
+// Cooked track package, loaded by mapping the file without parsing.
+// Layout: TrackPackHeader | TrackPackSection[numSections] | section data (each 64 byte aligned).
+// Element sizes are stored per section, a package cooked by a build with different structs is rejected.
+
+#define TRACK_PACK_FILE_NAME L"track.trackpack"
+
+enum class TrackPackSectionId : uint32_t
+{
+	Info = 1,
+	Surfaces,
+	Vertices,
+	Indices,
+	BvhNodes,
+	BvhTriangles,
+	Pits,
+	SlimPoints,
+	FatPoints,
+	FatPointDistances,
+	SplinePoints,
+	SplineNodes,
+	SplineDistances,
+	DistanceFieldInfo,
+	DistanceFieldTiles,
+	DistanceFieldCells,
+};
+
+struct TrackPackHeader
+{
+	static const uint32_t Magic = 0x50544450; // PDTP
+	static const uint32_t Version = 2;
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t numSections = 0;
+	uint32_t indexSize = 0; // sizeof(TriMeshIndex) of the cooking build
+	uint64_t sourceSurfacesHash = 0; // FNV-1a of surfaces.bin, detects stale packages
+	uint64_t sourceSplineHash = 0; // FNV-1a of spline.bin
+	uint64_t configHash = 0; // spline.ini settings the fat points were traced with
+};
+
+struct TrackPackSection
+{
+	uint32_t id = 0;
+	uint32_t elementSize = 0;
+	uint64_t offset = 0;
+	uint64_t count = 0;
+};
+
+struct TrackPackInfo
+{
+	vec3f boundsMin;
+	vec3f boundsMax;
+	uint32_t mergeSurfaces = 0; // BVH mesh triangles refer to merged meshes
+	uint32_t closedLoop = 0;
+	int32_t interpolateStep = 0;
+	int32_t splineSteps = 0;
+	float computedTrackWidth = 0;
+	float computedTrackLength = 0;
+};
+
+struct TrackPackSurface
+{
+	uint32_t firstVertex = 0;
+	uint32_t numVertices = 0;
+	uint32_t firstIndex = 0;
+	uint32_t numIndices = 0;
+	uint32_t sectorID = 0;
+	uint32_t collisionCategory = 0;
+	float gripMod = 0;
+	float damping = 0;
+	float sinHeight = 0;
+	float sinLength = 0;
+	float granularity = 0;
+	float dirtAdditiveK = 0;
+	float vibrationGain = 0;
+	float vibrationLength = 0;
+	float wavPitchSpeed = 0;
+	uint8_t isValidTrack = 0;
+	uint8_t isPitlane = 0;
+	uint8_t reserved[2] = {};
+};
+
+struct TrackPackWriter
+{
+	template<typename T>
+	inline void add(TrackPackSectionId id, const T* data, size_t count)
+	{
+		add(id, data, sizeof(T), count);
+	}
+
+	template<typename T>
+	inline void add(TrackPackSectionId id, const std::vector<T>& data)
+	{
+		add(id, data.data(), sizeof(T), data.size());
+	}
+
+	void add(TrackPackSectionId id, const void* data, size_t elementSize, size_t count);
+	bool save(const wchar_t* filename, TrackPackHeader header);
+
+	struct Item
+	{
+		TrackPackSection section;
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<Item> items;
+};
+
+struct TrackPack
+{
+	bool open(const wchar_t* filename);
+	void close();
+
+	inline bool isValid() const { return header != nullptr; }
+
+	// nullptr when section is missing or element size does not match
+	const void* getSection(TrackPackSectionId id, size_t elementSize, size_t& count) const;
+
+	template<typename T>
+	inline const T* get(TrackPackSectionId id, size_t& count) const
+	{
+		return (const T*)getSection(id, sizeof(T), count);
+	}
+
+	MappedFile file;
+	const TrackPackHeader* header = nullptr;
+	const TrackPackSection* sections = nullptr;
+};
+
+}
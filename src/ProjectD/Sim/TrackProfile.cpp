@@ -0,0 +1,61 @@
+#include "Sim/TrackProfile.h"
+
+namespace D {
+
+void TrackProfile::clear()
+{
+	samples.clear();
+	length = 0;
+}
+
+void TrackProfile::init(float _length, float _step, bool _closedLoop)
+{
+	length = _length;
+	step = _step;
+	invStep = 1.0f / _step;
+	closedLoop = _closedLoop;
+}
+
+TrackProfileSample TrackProfile::sample(float distance) const
+{
+	TrackProfileSample result;
+	const int n = (int)samples.size();
+	if (n < 2)
+		return result;
+
+	if (closedLoop)
+	{
+		distance = fmodf(distance, length);
+		if (distance < 0.0f)
+			distance += length;
+	}
+	else
+	{
+		distance = tclamp(distance, 0.0f, length);
+	}
+
+	const float x = distance * invStep;
+	const int k0 = tclamp(floorToInt(x), 0, closedLoop ? n - 1 : n - 2);
+	const int k1 = (k0 + 1 < n) ? k0 + 1 : 0;
+	const float u = tclamp(x - (float)k0, 0.0f, 1.0f);
+
+	const auto& a = samples[k0];
+	const auto& b = samples[k1];
+
+	result.curvature = a.curvature + (b.curvature - a.curvature) * u;
+	result.heading = wrapAngle(a.heading + wrapAngle(b.heading - a.heading) * u);
+	result.width = a.width + (b.width - a.width) * u;
+	result.elevation = a.elevation + (b.elevation - a.elevation) * u;
+	result.banking = a.banking + (b.banking - a.banking) * u;
+	result.grip = a.grip + (b.grip - a.grip) * u;
+
+	return result;
+}
+
+void TrackProfile::sample(const float* distances, size_t count, TrackProfileSample* out) const
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = sample(distances[i]);
+}
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Core/Math.h"
+#include <vector>
+
+namespace D {
+
+// track features at one distance along interpolated spline
+struct TrackProfileSample
+{
+	enum { NumFeatures = 6 };
+
+	float curvature = 0; // 1/m, change of heading per meter
+	float heading = 0; // radians, atan2(dir.x, dir.z)
+	float width = 0; // m, left to right side
+	float elevation = 0; // m, spline height
+	float banking = 0; // radians, positive when left side is higher
+	float grip = 0; // gripMod of surface under spline
+};
+
+// Features sampled every step meters of arc length (same knots as Track::arcSpline), O(1) lookup with linear interpolation.
+struct TrackProfile
+{
+	void clear();
+	void init(float length, float step, bool closedLoop);
+
+	inline bool isValid() const { return samples.size() >= 2; }
+
+	TrackProfileSample sample(float distance) const;
+	void sample(const float* distances, size_t count, TrackProfileSample* out) const;
+
+	std::vector<TrackProfileSample> samples;
+	float length = 0;
+	float step = 1.0f;
+	float invStep = 1.0f;
+	bool closedLoop = false;
+};
+
+}
@@ -1,15 +1,26 @@
 // https://pybind11.readthedocs.io/en/latest/basics.html
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 namespace py = pybind11;
 
+#if defined(PROJECTD_HEADLESS)
+#include "Sim/Simulator.h"
+#include "Sim/Track.h"
+#include "Car/CarImpl.h"
+#else
 #include "PlaygrounD.h"
+#endif
+#include "Sim/SimulatorPool.h"
 #include "Core/OS.h"
 #include "Core/DebugGL.h"
+#include "Core/ThreadPool.h"
 
 #include <unordered_map>
+#include <cstddef>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 // TODO: lame globals
 
@@ -19,6 +30,10 @@ static std::mutex g_simMux;
 static std::atomic<int> g_uniqSimId;
 static std::unordered_map<int, D::SimulatorPtr> g_simMap;
 
+static bool g_hasSeed = false;
+static uint64_t g_seed = 0;
+
+#if !defined(PROJECTD_HEADLESS)
 struct PySimulatorManager : public D::ISimulatorManager
 {
 	PySimulatorManager() { TRACE_CTOR(PySimulatorManager); }
@@ -43,13 +58,23 @@ static PySimulatorManager g_simManager;
 
 static std::unique_ptr<D::PlaygrounD> g_playground;
 
+static bool hasPlayground() { return g_playground ? true : false; }
+#else
+static bool hasPlayground() { return false; }
+#endif
+
 //
 // CORE
 //
 
-void setSeed(unsigned int seed)
+// seeds all existing simulators and the ones created afterwards
+void setSeed(uint64_t seed)
 {
-	srand(seed);
+	SIM_LOCK;
+	g_hasSeed = true;
+	g_seed = seed;
+	for (auto& iter : g_simMap)
+		iter.second->setSeed(seed);
 }
 
 void setLogFile(const std::string& path, bool overwrite = true)
@@ -124,6 +149,8 @@ int createSimulator(const std::string& basePath)
 
 		{
 			SIM_LOCK;
+			if (g_hasSeed)
+				sim->setSeed(g_seed);
 			g_simMap.insert({id, sim});
 		}
 
@@ -157,28 +184,210 @@ void destroyAllSimulators()
 	g_uniqSimId = 0;
 }
 
+static void stepSimulatorOnce(D::Simulator* sim, double dt)
+{
+	sim->step((float)dt, sim->physicsTime, sim->gameTime);
+
+#if !defined(PROJECTD_HEADLESS)
+	if (g_playground && g_playground->sim_.get() == sim)
+	{
+		g_playground->updateSimStats((float)dt, (float)sim->gameTime);
+	}
+#endif
+
+	sim->physicsTime += dt;
+	sim->gameTime += dt;
+}
+
+static void stepSimulatorImpl(D::Simulator* sim, double dt, int substeps)
+{
+	// simulator can be stepped by python thread or by one of the workers
+	sim->attachThread();
+
+	for (int i = 0; i < substeps; ++i)
+	{
+		stepSimulatorOnce(sim, dt);
+	}
+}
+
 void stepSimulator(int simId, double dt = (1.0 / 333.0))
 {
 	auto* sim = getSimulator(simId);
 	if (sim && sim->physics)
 	{
-		sim->step((float)dt, sim->physicsTime, sim->gameTime);
+		stepSimulatorImpl(sim, dt, 1);
+	}
+
+	if (!hasPlayground())
+	{
+		D::DebugGL::get().clear();
+	}
+}
+
+//
+// WORKERS
+//
+
+struct PyStepJob
+{
+	D::SimulatorPtr sim;
+	double dt = 0;
+	int substeps = 0;
+};
 
-		if (g_playground && g_playground->sim_.get() == sim)
+static std::mutex g_workerMux;
+static std::unique_ptr<D::ThreadPool> g_workerPool; // steps batch index i on worker (i % numThreads), idle workers steal
+static int g_numWorkers = 0;
+
+void setWorkerThreads(int numThreads)
+{
+	D::log_printf(L"[PY] setWorkerThreads numThreads=%d", numThreads);
+
+	std::lock_guard<std::mutex> lock(g_workerMux);
+	g_numWorkers = numThreads;
+	g_workerPool.reset();
+}
+
+void stopWorkerThreads()
+{
+	std::lock_guard<std::mutex> lock(g_workerMux);
+	g_workerPool.reset();
+}
+
+void stepSimulators(const std::vector<int>& simIds, double dt = (1.0 / 333.0), int substeps = 1)
+{
+	std::vector<PyStepJob> batch;
+	batch.reserve(simIds.size());
+
+	{
+		SIM_LOCK;
+		std::unordered_map<int, size_t> jobIndex;
+		for (auto simId : simIds)
 		{
-			g_playground->updateSimStats((float)dt, (float)sim->gameTime);
+			auto sim = getSimulatorShared(simId);
+			if (sim && sim->physics)
+			{
+				// repeated id steps again, same job keeps the steps serial
+				auto iter = jobIndex.find(simId);
+				if (iter != jobIndex.end())
+				{
+					batch[iter->second].substeps += substeps;
+					continue;
+				}
+
+				jobIndex.insert({simId, batch.size()});
+				batch.push_back({sim, dt, substeps});
+			}
+		}
+	}
+
+	if (!batch.empty())
+	{
+		py::gil_scoped_release release;
+		std::lock_guard<std::mutex> lock(g_workerMux);
+
+		if (!g_workerPool)
+		{
+			// caller thread participates, 0: hardware concurrency
+			g_workerPool.reset(new D::ThreadPool(g_numWorkers));
 		}
 
-		sim->physicsTime += dt;
-		sim->gameTime += dt;
+		g_workerPool->parallelFor(batch.size(), [&batch](size_t i)
+		{
+			auto& job = batch[i];
+			try
+			{
+				stepSimulatorImpl(job.sim.get(), job.dt, job.substeps);
+			}
+			catch (const std::exception& ex)
+			{
+				D::log_printf(L"EXCEPTION: %S", ex.what());
+			}
+		});
 	}
 
-	if (!g_playground)
+	if (!hasPlayground())
 	{
 		D::DebugGL::get().clear();
 	}
 }
 
+//
+// STATE
+//
+
+py::bytes saveSimulatorState(int simId)
+{
+	auto* sim = getSimulator(simId);
+	if (!(sim && sim->physics))
+		throw py::value_error("invalid simId");
+
+	std::vector<uint8_t> buffer;
+	{
+		py::gil_scoped_release release;
+		sim->saveState(buffer);
+	}
+
+	return py::bytes((const char*)buffer.data(), buffer.size());
+}
+
+void restoreSimulatorState(int simId, const py::bytes& state)
+{
+	auto* sim = getSimulator(simId);
+	if (!(sim && sim->physics))
+		throw py::value_error("invalid simId");
+
+	char* data = nullptr;
+	Py_ssize_t size = 0;
+	if (PyBytes_AsStringAndSize(state.ptr(), &data, &size) != 0)
+		throw py::error_already_set();
+
+	bool restored = false;
+	{
+		py::gil_scoped_release release;
+		restored = sim->restoreState(data, (size_t)size);
+	}
+
+	if (!restored)
+		throw py::value_error("invalid simulator state");
+}
+
+void setSimulatorSeed(int simId, uint64_t seed)
+{
+	auto* sim = getSimulator(simId);
+	GUARD_FATAL(sim && sim->physics);
+	sim->setSeed(seed);
+}
+
+void setSimulatorDeterministic(int simId, bool deterministic, bool stateHash)
+{
+	auto* sim = getSimulator(simId);
+	GUARD_FATAL(sim && sim->physics);
+	sim->setDeterministic(deterministic);
+	sim->stateHashEnabled = stateHash ? 1 : 0;
+}
+
+// space names as in sim.ini [COLLISION_SPACE]: SIMPLE, HASH, QUADTREE, SAP
+void setSimulatorCollisionSpaces(int simId, const std::string& staticSpace, const std::string& dynamicSpace)
+{
+	auto* sim = getSimulator(simId);
+	GUARD_FATAL(sim && sim->physics);
+
+	auto config = sim->spaceConfig;
+	if (!D::parseCollisionSpaceType(D::strw(staticSpace), config.staticType))
+		throw py::value_error("unknown static collision space: " + staticSpace);
+	if (!D::parseCollisionSpaceType(D::strw(dynamicSpace), config.dynamicType))
+		throw py::value_error("unknown dynamic collision space: " + dynamicSpace);
+	sim->setCollisionSpaces(config);
+}
+
+uint64_t getSimulatorStateHash(int simId)
+{
+	auto* sim = getSimulator(simId);
+	GUARD_FATAL(sim && sim->physics);
+	return sim->stateHash;
+}
+
 //
 // TRACK
 //
@@ -201,6 +410,26 @@ void loadTrack(int simId, const std::string &trackName)
 	}
 }
 
+bool cookTrack(int simId, const std::string &trackName)
+{
+	D::log_printf(L"[PY] cookTrack simId=%d trackName=%S", simId, trackName.c_str());
+
+	try
+	{
+		auto* sim = getSimulator(simId);
+		if (sim && sim->physics)
+		{
+			return sim->cookTrack(D::strw(trackName));
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		D::log_printf(L"EXCEPTION: %S", ex.what());
+	}
+
+	return false;
+}
+
 void unloadTrack(int simId)
 {
 	D::log_printf(L"[PY] unloadTrack simId=%d", simId);
@@ -321,10 +550,262 @@ void getCarState(int simId, int carId, D::CarState& state)
 	auto* car = getCar(simId, carId);
 	if (car)
 	{
-		state = *(car->state.get());
+		state = *(car->state);
 	}
 }
 
+// offsets [N] in meters along driving direction -> [N, 6]: curvature, heading, width, elevation, banking, grip
+py::array_t<float> sampleCarTrackProfile(int simId, int carId, const py::array_t<float, py::array::c_style | py::array::forcecast>& offsets)
+{
+	static_assert(sizeof(D::TrackProfileSample) == sizeof(float) * D::TrackProfileSample::NumFeatures, "TrackProfileSample layout");
+
+	const int n = (int)offsets.size();
+	py::array_t<float> result({n, (int)D::TrackProfileSample::NumFeatures});
+	auto* out = (D::TrackProfileSample*)result.mutable_data();
+
+	auto* car = getCar(simId, carId);
+	if (car)
+		car->sampleTrackProfile(offsets.data(), (size_t)n, out);
+	else
+		std::fill(out, out + n, D::TrackProfileSample());
+
+	return result;
+}
+
+// applies controls, runs substeps and returns (summed stepReward, number of steps done), copies car state to optional output
+static std::pair<float, int> stepCarImpl(int simId, int carId, bool smooth, const D::CarControls& controls, D::CarState* state, 
+	int substeps, double dt, bool stopOnCollision, bool stopOnOutOfTrack)
+{
+	float reward = 0;
+	int stepsDone = 0;
+
+	D::SimulatorPtr sim;
+	{
+		SIM_LOCK;
+		sim = getSimulatorShared(simId);
+	}
+
+	auto* car = sim ? sim->getCar(carId) : nullptr;
+	if (car && sim->physics)
+	{
+		car->controls = controls;
+		car->smoothSteer = smooth;
+
+		py::gil_scoped_release release;
+		sim->attachThread();
+
+		while (stepsDone < substeps)
+		{
+			stepSimulatorOnce(sim.get(), dt);
+			stepsDone++;
+
+			reward += car->state->stepReward;
+
+			if ((stopOnCollision && car->state->collisionFlag) || (stopOnOutOfTrack && car->state->outOfTrackFlag))
+				break;
+		}
+
+		if (state && state != car->state)
+			*state = *(car->state);
+	}
+
+	if (!hasPlayground())
+	{
+		D::DebugGL::get().clear();
+	}
+
+	return {reward, stepsDone};
+}
+
+std::pair<float, int> stepCar(int simId, int carId, bool smooth, const D::CarControls& controls, D::CarState& state, 
+	int substeps = 1, double dt = (1.0 / 333.0), bool stopOnCollision = true, bool stopOnOutOfTrack = true)
+{
+	return stepCarImpl(simId, carId, smooth, controls, &state, substeps, dt, stopOnCollision, stopOnOutOfTrack);
+}
+
+//
+// STATE BUFFER
+//
+
+// contiguous CarState storage for all cars of given simulators, cars write directly into it (see Car::bindState)
+struct PyCarStateBuffer : public D::NonCopyable
+{
+	struct Slot
+	{
+		std::weak_ptr<D::Simulator> sim;
+		int simId = 0;
+		int carId = 0;
+	};
+
+	PyCarStateBuffer(const std::vector<int>& simIds)
+	{
+		SIM_LOCK;
+
+		for (auto simId : simIds)
+		{
+			auto sim = getSimulatorShared(simId);
+			if (sim)
+			{
+				for (auto* car : sim->cars)
+					slots.push_back({sim, simId, car->physicsGUID});
+			}
+		}
+
+		states.reset(new D::CarState[slots.size()]);
+
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			auto sim = slots[i].sim.lock();
+			sim->getCar(slots[i].carId)->bindState(&states[i]);
+		}
+	}
+
+	~PyCarStateBuffer()
+	{
+		release();
+	}
+
+	void release()
+	{
+		SIM_LOCK;
+
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			auto sim = slots[i].sim.lock();
+			auto* car = sim ? sim->getCar(slots[i].carId) : nullptr;
+			if (car && car->state == &states[i])
+				car->bindState(nullptr);
+		}
+
+		slots.clear();
+	}
+
+	std::vector<int> getSimIds() const
+	{
+		std::vector<int> ids;
+		for (auto& slot : slots)
+			ids.push_back(slot.simId);
+		return ids;
+	}
+
+	std::vector<int> getCarIds() const
+	{
+		std::vector<int> ids;
+		for (auto& slot : slots)
+			ids.push_back(slot.carId);
+		return ids;
+	}
+
+	std::unique_ptr<D::CarState[]> states;
+	std::vector<Slot> slots;
+};
+
+static py::dtype makeStructDtype(const std::vector<std::tuple<const char*, py::object, size_t>>& fields, size_t itemSize)
+{
+	py::list names, formats, offsets;
+	for (auto& f : fields)
+	{
+		names.append(std::get<0>(f));
+		formats.append(std::get<1>(f));
+		offsets.append(std::get<2>(f));
+	}
+
+	py::dict desc;
+	desc["names"] = names;
+	desc["formats"] = formats;
+	desc["offsets"] = offsets;
+	desc["itemsize"] = itemSize;
+	return py::dtype::from_args(desc);
+}
+
+static py::dtype getCarStateDtype()
+{
+	using D::CarState;
+	using D::CarControls;
+
+	#define PY_FIELD(type, name, fmt) std::make_tuple(#name, (py::object)py::str(fmt), offsetof(type, name))
+
+	// leaked on purpose, must not be destroyed after interpreter shutdown
+	static auto* controlsDtype = new py::dtype(makeStructDtype({
+		PY_FIELD(CarControls, steer, "<f4"),
+		PY_FIELD(CarControls, clutch, "<f4"),
+		PY_FIELD(CarControls, brake, "<f4"),
+		PY_FIELD(CarControls, handBrake, "<f4"),
+		PY_FIELD(CarControls, gas, "<f4"),
+		PY_FIELD(CarControls, isShifterSupported, "i1"),
+		PY_FIELD(CarControls, requestedGearIndex, "i1"),
+		PY_FIELD(CarControls, gearUp, "i1"),
+		PY_FIELD(CarControls, gearDn, "i1"),
+	}, sizeof(CarControls)));
+
+	static auto* stateDtype = new py::dtype(makeStructDtype({
+		PY_FIELD(CarState, carId, "<i4"),
+		PY_FIELD(CarState, simId, "<i4"),
+		PY_FIELD(CarState, timestamp, "<f4"),
+		std::make_tuple("controls", (py::object)*controlsDtype, offsetof(CarState, controls)),
+		PY_FIELD(CarState, collisionFlag, "<i4"),
+		PY_FIELD(CarState, outOfTrackFlag, "<i4"),
+		PY_FIELD(CarState, trackPointId, "<i4"),
+		PY_FIELD(CarState, lastTrackPointTimestamp, "<f4"),
+		PY_FIELD(CarState, trackLocation, "<f4"),
+		PY_FIELD(CarState, bodyVsTrack, "<f4"),
+		PY_FIELD(CarState, velocityVsTrack, "<f4"),
+		PY_FIELD(CarState, engineRPM, "<f4"),
+		PY_FIELD(CarState, speedMS, "<f4"),
+		PY_FIELD(CarState, gear, "<i4"),
+		PY_FIELD(CarState, gearGrinding, "<i4"),
+		PY_FIELD(CarState, bodyMatrix, "(4,4)<f4"),
+		PY_FIELD(CarState, bodyPos, "(3,)<f4"),
+		PY_FIELD(CarState, bodyEuler, "(3,)<f4"),
+		PY_FIELD(CarState, accG, "(3,)<f4"),
+		PY_FIELD(CarState, velocity, "(3,)<f4"),
+		PY_FIELD(CarState, localVelocity, "(3,)<f4"),
+		PY_FIELD(CarState, angularVelocity, "(3,)<f4"),
+		PY_FIELD(CarState, localAngularVelocity, "(3,)<f4"),
+		PY_FIELD(CarState, hubMatrix, "(4,4,4)<f4"),
+		PY_FIELD(CarState, tyreContacts, "(4,3)<f4"),
+		PY_FIELD(CarState, tyreLoad, "(4,)<f4"),
+		PY_FIELD(CarState, tyreAngularSpeed, "(4,)<f4"),
+		PY_FIELD(CarState, tyreSlipRatio, "(4,)<f4"),
+		PY_FIELD(CarState, tyreNdSlip, "(4,)<f4"),
+		PY_FIELD(CarState, probes, "(10,)<f4"),
+		PY_FIELD(CarState, lookAhead, "(5,)<f4"),
+		PY_FIELD(CarState, stepReward, "<f4"),
+		PY_FIELD(CarState, totalReward, "<f4"),
+	}, sizeof(CarState)));
+
+	#undef PY_FIELD
+
+	static_assert(CarState::MaxProbes == 10 && CarState::MaxLookAhead == 5, "update CarState dtype");
+	return *stateDtype;
+}
+
+std::unique_ptr<PyCarStateBuffer> createCarStateBuffer(const std::vector<int>& simIds)
+{
+	D::log_printf(L"[PY] createCarStateBuffer numSims=%d", (int)simIds.size());
+	return std::make_unique<PyCarStateBuffer>(simIds);
+}
+
+// same as stepCar but state is written in place to the car slot of buffer (no copy when car is bound to it)
+std::pair<float, int> stepCarBuffered(int simId, int carId, bool smooth, const D::CarControls& controls, PyCarStateBuffer& buffer, 
+	int substeps = 1, double dt = (1.0 / 333.0), bool stopOnCollision = true, bool stopOnOutOfTrack = true)
+{
+	D::CarState* state = nullptr;
+	for (size_t i = 0; i < buffer.slots.size(); ++i)
+	{
+		if (buffer.slots[i].simId == simId && buffer.slots[i].carId == carId)
+		{
+			state = &buffer.states[i];
+			break;
+		}
+	}
+
+	if (!state)
+		throw py::value_error("car is not in state buffer");
+
+	return stepCarImpl(simId, carId, smooth, controls, state, substeps, dt, stopOnCollision, stopOnOutOfTrack);
+}
+
 void setCarTune(int simId, int carId, const std::string& name, float value)
 {
 	auto* car = getCar(simId, carId);
@@ -362,10 +843,71 @@ float getScoringVar(int simId, int carId, const std::string& name)
 	return 0.0f;
 }
 
+//
+// POOL
+//
+
+// controls: float32 [numSimulators, K], columns follow CarControls: steer, clutch, brake, handBrake, gas
+static void unpackPoolControls(const D::SimulatorPool& pool, const py::array_t<float, py::array::c_style | py::array::forcecast>& input, std::vector<D::CarControls>& controls)
+{
+	const int n = pool.getSimulatorCount();
+	if (!(input.ndim() == 2 && input.shape(0) == n && input.shape(1) >= 1 && input.shape(1) <= 5))
+		throw py::value_error("controls must have shape [numSimulators, 1..5]");
+
+	static_assert(offsetof(D::CarControls, gas) == sizeof(float) * 4, "CarControls layout");
+
+	const int k = (int)input.shape(1);
+	const float* src = input.data();
+
+	controls.resize(n);
+	for (int i = 0; i < n; ++i)
+	{
+		float* dst = &controls[i].steer;
+		for (int j = 0; j < k; ++j)
+			dst[j] = src[i * k + j];
+	}
+}
+
+py::array_t<float> poolReset(D::SimulatorPool& pool)
+{
+	py::array_t<float> obs({pool.getSimulatorCount(), pool.getObservationSize()});
+	float* pobs = obs.mutable_data();
+	{
+		py::gil_scoped_release release;
+		pool.reset(pobs);
+	}
+	return obs;
+}
+
+py::tuple poolStep(D::SimulatorPool& pool, const py::array_t<float, py::array::c_style | py::array::forcecast>& input)
+{
+	std::vector<D::CarControls> controls;
+	unpackPoolControls(pool, input, controls);
+
+	const int n = pool.getSimulatorCount();
+	py::array_t<float> obs({n, pool.getObservationSize()});
+	py::array_t<float> terminalObs({n, pool.getObservationSize()});
+	py::array_t<float> rewards(n);
+	py::array_t<bool> dones(n);
+
+	float* pobs = obs.mutable_data();
+	float* pterm = terminalObs.mutable_data();
+	float* prew = rewards.mutable_data();
+	uint8_t* pdone = (uint8_t*)dones.mutable_data();
+	{
+		py::gil_scoped_release release;
+		pool.step(controls.data(), pobs, prew, pdone, pterm);
+	}
+
+	return py::make_tuple(obs, rewards, dones, terminalObs);
+}
+
 //
 // PLAYGROUND
 //
 
+#if !defined(PROJECTD_HEADLESS)
+
 static std::unique_ptr<std::thread> g_playgroundThread;
 
 void launchPlaygroundInOwnThread(const std::string& basePath)
@@ -412,14 +954,6 @@ void shutPlayground()
 	g_playground.reset();
 }
 
-void shutAll()
-{
-	D::log_printf(L"[PY] shutAll");
-
-	shutPlayground();
-	destroyAllSimulators();
-}
-
 void tickPlayground()
 {
 	if (g_playground && !g_playgroundThread)
@@ -508,6 +1042,21 @@ int getActiveCar()
 	return -1;
 }
 
+#else // PROJECTD_HEADLESS
+
+void shutPlayground() {}
+
+#endif
+
+void shutAll()
+{
+	D::log_printf(L"[PY] shutAll");
+
+	stopWorkerThreads();
+	shutPlayground();
+	destroyAllSimulators();
+}
+
 //
 // MODULE
 //
@@ -597,6 +1146,69 @@ PYBIND11_MODULE(PyProjectD, m)
 		.def_readonly("totalReward", &D::CarState::totalReward)
 	;
 
+	py::class_<PyCarStateBuffer> py_CarStateBuffer(m, "CarStateBuffer");
+	py_CarStateBuffer
+		.def("__len__", [](const PyCarStateBuffer& b) { return b.slots.size(); })
+		.def("array", [](py::object self)
+		{
+			auto& b = self.cast<PyCarStateBuffer&>();
+			return py::array(getCarStateDtype(), {b.slots.size()}, {sizeof(D::CarState)}, b.states.get(), self);
+		}, "zero-copy structured view, valid while buffer is alive")
+		.def("release", &PyCarStateBuffer::release)
+		.def_property_readonly("simIds", &PyCarStateBuffer::getSimIds)
+		.def_property_readonly("carIds", &PyCarStateBuffer::getCarIds)
+	;
+
+	py::class_<D::SimulatorPoolConfig> py_SimulatorPoolConfig(m, "SimulatorPoolConfig");
+	py_SimulatorPoolConfig.def(py::init<>())
+		.def_readwrite("basePath", &D::SimulatorPoolConfig::basePath)
+		.def_readwrite("trackName", &D::SimulatorPoolConfig::trackName)
+		.def_readwrite("carModel", &D::SimulatorPoolConfig::carModel)
+		.def_readwrite("numSimulators", &D::SimulatorPoolConfig::numSimulators)
+		.def_readwrite("numThreads", &D::SimulatorPoolConfig::numThreads)
+		.def_readwrite("substeps", &D::SimulatorPoolConfig::substeps)
+		.def_readwrite("dt", &D::SimulatorPoolConfig::dt)
+		.def_readwrite("seed", &D::SimulatorPoolConfig::seed)
+		.def_readwrite("deterministic", &D::SimulatorPoolConfig::deterministic)
+		.def_readwrite("smoothSteer", &D::SimulatorPoolConfig::smoothSteer)
+		.def_readwrite("autoClutch", &D::SimulatorPoolConfig::autoClutch)
+		.def_readwrite("autoShift", &D::SimulatorPoolConfig::autoShift)
+		.def_readwrite("autoBlip", &D::SimulatorPoolConfig::autoBlip)
+		.def_readwrite("teleportMode", &D::SimulatorPoolConfig::teleportMode)
+		.def_readwrite("autoReset", &D::SimulatorPoolConfig::autoReset)
+		.def_readwrite("terminateOnHit", &D::SimulatorPoolConfig::terminateOnHit)
+		.def_readwrite("terminateOffTrack", &D::SimulatorPoolConfig::terminateOffTrack)
+		.def_readwrite("terminateWhenStuck", &D::SimulatorPoolConfig::terminateWhenStuck)
+		.def_readwrite("terminateHitPenalty", &D::SimulatorPoolConfig::terminateHitPenalty)
+		.def_readwrite("terminateOffTrackPenalty", &D::SimulatorPoolConfig::terminateOffTrackPenalty)
+		.def_readwrite("terminateStuckPenalty", &D::SimulatorPoolConfig::terminateStuckPenalty)
+		.def_readwrite("terminateLowReward", &D::SimulatorPoolConfig::terminateLowReward)
+		.def_readwrite("stuckTimeout", &D::SimulatorPoolConfig::stuckTimeout)
+	;
+
+	py::class_<D::SimulatorPool> py_SimulatorPool(m, "SimulatorPool");
+	py_SimulatorPool.def(py::init<>())
+		.def("init", &D::SimulatorPool::init, py::call_guard<py::gil_scoped_release>())
+		.def("reset", &poolReset, "returns obs [N, obsSize]")
+		.def("step", &poolStep, "controls [N, K] -> (obs, rewards, dones, terminalObs)")
+		.def("getSimulatorCount", &D::SimulatorPool::getSimulatorCount)
+		.def("getObservationSize", &D::SimulatorPool::getObservationSize)
+		.def("getLookAheadCount", &D::SimulatorPool::getLookAheadCount)
+		.def("getProbeCount", &D::SimulatorPool::getProbeCount)
+		.def("getProfileCount", &D::SimulatorPool::getProfileCount)
+		.def("getCarState", [](const D::SimulatorPool& pool, int index, D::CarState& state) { state = *(pool.getCar(index)->state); })
+		.def("setCarTune", [](D::SimulatorPool& pool, const std::string& name, float value)
+		{
+			for (int i = 0; i < pool.getSimulatorCount(); ++i)
+				pool.getCar(i)->setup->setTune(name, value);
+		})
+		.def("setScoringVar", [](D::SimulatorPool& pool, const std::string& name, float value)
+		{
+			for (int i = 0; i < pool.getSimulatorCount(); ++i)
+				pool.getCar(i)->scoring->config->setVar(name, value);
+		})
+	;
+
 	m.def("setSeed", &setSeed, "");
 	m.def("setLogFile", &setLogFile, "");
 	m.def("clearLogFile", &clearLogFile, "");
@@ -605,9 +1217,19 @@ PYBIND11_MODULE(PyProjectD, m)
 	m.def("createSimulator", &createSimulator, "");
 	m.def("destroySimulator", &destroySimulator, "");
 	m.def("stepSimulator", &stepSimulator, "");
+	m.def("stepSimulators", &stepSimulators, "", py::arg("simIds"), py::arg("dt") = (1.0 / 333.0), py::arg("substeps") = 1);
+	m.def("setWorkerThreads", &setWorkerThreads, "");
+	m.def("stopWorkerThreads", &stopWorkerThreads, "");
+	m.def("saveSimulatorState", &saveSimulatorState, "");
+	m.def("restoreSimulatorState", &restoreSimulatorState, "");
+	m.def("setSimulatorSeed", &setSimulatorSeed, "");
+	m.def("setSimulatorDeterministic", &setSimulatorDeterministic, "", py::arg("simId"), py::arg("deterministic"), py::arg("stateHash") = true);
+	m.def("getSimulatorStateHash", &getSimulatorStateHash, "");
+	m.def("setSimulatorCollisionSpaces", &setSimulatorCollisionSpaces, "");
 
 	m.def("loadTrack", &loadTrack, "");
 	m.def("unloadTrack", &unloadTrack, "");
+	m.def("cookTrack", &cookTrack, "");
 
 	m.def("addCar", &addCar, "");
 	m.def("removeCar", &removeCar, "");
@@ -619,15 +1241,23 @@ PYBIND11_MODULE(PyProjectD, m)
 	m.def("setCarControls", &setCarControls, "");
 	m.def("setCarAssists", &setCarAssists, "");
 	m.def("getCarState", &getCarState, "");
+	m.def("sampleCarTrackProfile", &sampleCarTrackProfile, "");
+	m.def("createCarStateBuffer", &createCarStateBuffer, "");
+	m.def("stepCar", &stepCar, "", py::arg("simId"), py::arg("carId"), py::arg("smooth"), py::arg("controls"), py::arg("state"), 
+		py::arg("substeps") = 1, py::arg("dt") = (1.0 / 333.0), py::arg("stopOnCollision") = true, py::arg("stopOnOutOfTrack") = true);
+	m.def("stepCar", &stepCarBuffered, "", py::arg("simId"), py::arg("carId"), py::arg("smooth"), py::arg("controls"), py::arg("state"), 
+		py::arg("substeps") = 1, py::arg("dt") = (1.0 / 333.0), py::arg("stopOnCollision") = true, py::arg("stopOnOutOfTrack") = true);
 	m.def("setCarRawTune", &setCarRawTune, "");
 	m.def("setCarTune", &setCarTune, "");
 	m.def("setScoringVar", &setScoringVar, "");
 	m.def("getScoringVar", &getScoringVar, "");
 
-	m.def("launchPlaygroundInOwnThread", &launchPlaygroundInOwnThread, "");
-	m.def("initPlayground", &initPlayground, "");
 	m.def("shutPlayground", &shutPlayground, "");
 	m.def("shutAll", &shutAll, "");
+
+#if !defined(PROJECTD_HEADLESS)
+	m.def("launchPlaygroundInOwnThread", &launchPlaygroundInOwnThread, "");
+	m.def("initPlayground", &initPlayground, "");
 	m.def("tickPlayground", &tickPlayground, "");
 	m.def("isPlaygroundInitialized", &isPlaygroundInitialized, "");
 	m.def("isPlaygroundExited", &isPlaygroundExited, "");
@@ -638,4 +1268,5 @@ PYBIND11_MODULE(PyProjectD, m)
 	m.def("setActiveCar", &setActiveCar, "");
 	m.def("getActiveSimulator", &getActiveSimulator, "");
 	m.def("getActiveCar", &getActiveCar, "");
+#endif
 }